@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <spdlog/spdlog.h>
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <cstring>
+#endif
+#include "JsonDocument.h"
+#include "JsonLexer.h"
+#include "JsonOnDemand.h"
+#include "JsonParser.h"
+#include "JsonTape.h"
+#include "TapeFile.h"
+#include "corpus.h"
+
+namespace {
+  // 防止被测代码的结果被编译器优化掉
+  volatile size_t sink;
+
+  // 重复运行取最快的一次，返回 MB/s
+  template <typename Fn>
+  double measure(size_t bytes, Fn&& fn, int rounds = 5) {
+    double best = 1e100;
+    for (int k = 0; k < rounds; ++k) {
+      auto start = std::chrono::steady_clock::now();
+      fn();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    return bytes / best / 1e6;
+  }
+
+  // 运行一次 fn 并统计用户态的分支预测失败次数，内核不允许时返回 -1
+  template <typename Fn>
+  long long branchMisses(Fn&& fn) {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd < 0) {
+      fn();
+      return -1;
+    }
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    fn();
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+    close(fd);
+    return count;
+#else
+    fn();
+    return -1;
+#endif
+  }
+
+  void report(std::string_view group, std::string_view name, double mbps) {
+    spdlog::info("{:<24} {:<28} {:>10.1f} MB/s", group, name, mbps);
+  }
+
+  // 同时给出每 KB 输入的分支预测失败次数，用来衡量状态机分派的可预测性
+  template <typename Fn>
+  void reportLexer(std::string_view group, std::string_view name, size_t bytes, Fn&& fn) {
+    double mbps = measure(bytes, fn);
+    long long misses = branchMisses(fn);
+    if (misses < 0) {
+      spdlog::info("{:<24} {:<28} {:>10.1f} MB/s   branch-misses n/a", group, name, mbps);
+    } else {
+      spdlog::info("{:<24} {:<28} {:>10.1f} MB/s {:>8.2f} branch-misses/KB",
+                   group, name, mbps, misses * 1024.0 / bytes);
+    }
+  }
+
+  // 逐字节跳过空白，即改动前 State::INIT 的做法
+  const char* skipWhitespaceBytewise(const char* p, const char* end) {
+    while (p < end && util::isBlank(*p)) ++p;
+    return p;
+  }
+
+  // 从 runs 中的每个位置开始调用 skip，按跳过的字节数计算吞吐量
+  template <typename Skip>
+  double measureSkip(std::string_view input, const std::vector<size_t>& runs, Skip skip) {
+    size_t bytes = 0;
+    for (auto start : runs) {
+      bytes += skip(input.data() + start, input.data() + input.size()) - (input.data() + start);
+    }
+    return measure(bytes, [&]() {
+      size_t total = 0;
+      for (auto start : runs) {
+        total += skip(input.data() + start, input.data() + input.size()) - input.data();
+      }
+      sink = total;
+    });
+  }
+
+  // 空白跳过：分别在紧凑和缩进排版的同一份数据上比较逐字节和 SWAR 的做法
+  // State::INIT 读到第一个空白后才会调用跳过函数，所以每段从第二个空白字节开始计
+  void benchWhitespace(std::string_view name, std::string_view input) {
+    std::vector<size_t> runs;
+    bool inString = false;
+    for (size_t k = 0; k < input.size(); ++k) {
+      char c = input[k];
+      if (inString) {
+        if (c == '\\') {
+          ++k;
+        } else if (c == '"') {
+          inString = false;
+        }
+      } else if (c == '"') {
+        inString = true;
+      } else if (util::isBlank(c) && (k == 0 || !util::isBlank(input[k - 1]))) {
+        runs.push_back(k + 1);
+      }
+    }
+    spdlog::info("{}: {} bytes, {} whitespace runs", name, input.size(), runs.size());
+
+    std::string group = "whitespace/" + std::string(name);
+    if (!runs.empty()) {
+      report(group, "bytewise", measureSkip(input, runs, skipWhitespaceBytewise));
+      report(group, "swar", measureSkip(input, runs, simd::skipWhitespace));
+    }
+
+    JsonLexer lexer;
+    TokenTape tape;
+    StructuralIndex index;
+    group = "lex/" + std::string(name);
+    reportLexer(group, "lexTape", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "index + lexTape", input.size(), [&]() {
+      index.build(input);
+      lexer.lexTape(input, index, tape);
+      sink = tape.tokens.size();
+    });
+  }
+
+  // 逐字节跳过数字，即改动前数值状态的做法
+  const char* skipDigitsBytewise(const char* p, const char* end) {
+    while (p < end && util::isDigit(*p)) ++p;
+    return p;
+  }
+
+  // 数值数组：比较逐字节和 SWAR 跳过数字，以及词法分析时是否同时解析数值
+  // 数值状态读到第二个数字后才会调用跳过函数，所以每段从第二个数字开始计
+  void benchNumbers(std::string_view name, std::string_view input) {
+    std::vector<size_t> runs;
+    for (size_t k = 1; k < input.size(); ++k) {
+      if (util::isDigit(input[k]) && util::isDigit(input[k - 1])
+          && (k < 2 || !util::isDigit(input[k - 2]))) {
+        runs.push_back(k);
+      }
+    }
+    spdlog::info("{}: {} bytes, {} digit runs", name, input.size(), runs.size());
+
+    std::string group = "digits/" + std::string(name);
+    report(group, "bytewise", measureSkip(input, runs, skipDigitsBytewise));
+    report(group, "swar", measureSkip(input, runs, simd::skipDigits));
+
+    JsonLexer lexer, typed(JsonLexer::Options{true, false}), exact(JsonLexer::Options{false, true});
+    TokenTape tape;
+    group = "numbers/" + std::string(name);
+    reportLexer(group, "lexTape", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "lexTape + parseNumbers", input.size(), [&]() {
+      typed.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "lexTape + exactDecimals", input.size(), [&]() {
+      exact.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+  }
+
+  // 单独再扫一遍整个输入做 UTF-8 校验，即把校验放在词法分析之外的做法
+  bool validateUtf8Separately(std::string_view input) {
+    const char* p = input.data();
+    const char* end = p + input.size();
+    while ((p = simd::findStringSpecialUtf8(p, end)) != end) {
+      if (static_cast<uint8_t>(*p) >= 0x80) return false;
+      ++p;
+    }
+    return true;
+  }
+
+  // 字符串内容校验：不校验、与字符串扫描合在一起校验、不校验再单独扫一遍
+  void benchStrings(std::string_view name, std::string_view input) {
+    JsonLexer::Options trustedOptions;
+    trustedOptions.validateStrings = false;
+    JsonLexer validating, trusted(trustedOptions);
+    TokenTape tape;
+    std::string group = "strings/" + std::string(name);
+    reportLexer(group, "trusted", input.size(), [&]() {
+      trusted.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "fused validation", input.size(), [&]() {
+      validating.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "trusted + separate pass", input.size(), [&]() {
+      trusted.lexTape(input, tape);
+      sink = tape.tokens.size() + validateUtf8Separately(input);
+    });
+  }
+
+  // 词法分析加上把每个字符串解码出来，转义越多解码占的比重越大
+  void benchUnescape(std::string_view name, std::string_view input) {
+    JsonLexer lexer;
+    TokenTape tape;
+    std::string scratch;
+    std::string group = "unescape/" + std::string(name);
+    reportLexer(group, "lexTape", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "lexTape + decode", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      size_t total = 0;
+      for (const auto& token : tape.tokens) {
+        if (token.type == TokenType::STRING) total += TokenTape::string(token, input, scratch).size();
+      }
+      sink = total;
+    });
+  }
+
+  // 建立 DOM 相对只做词法分析的开销；复用同一个文档时 arena 的块不再向系统申请，
+  // 每次新建文档则包含申请和整体释放 arena 的开销
+  // 只统计值的个数和数值之和的处理器，代表直接在事件上构造业务对象、不建中间结构的用法
+  struct SumHandler {
+    size_t values = 0;
+    double total = 0;
+
+    bool onObjectStart() {
+      return true;
+    }
+
+    bool onObjectEnd(size_t) {
+      ++values;
+      return true;
+    }
+
+    bool onArrayStart() {
+      return true;
+    }
+
+    bool onArrayEnd(size_t) {
+      ++values;
+      return true;
+    }
+
+    bool onKey(std::string_view) {
+      return true;
+    }
+
+    bool onString(std::string_view) {
+      ++values;
+      return true;
+    }
+
+    bool onNumber(const TapeToken& token, std::string_view) {
+      ++values;
+      total += TokenTape::toDouble(token);
+      return true;
+    }
+
+    bool onBool(bool) {
+      ++values;
+      return true;
+    }
+
+    bool onNull() {
+      ++values;
+      return true;
+    }
+  };
+
+  void benchDocument(std::string_view name, std::string_view input) {
+    JsonLexer lexer(JsonLexer::Options{true});
+    TokenTape tape;
+    JsonDocument reused;
+    std::string group = "dom/" + std::string(name);
+    reportLexer(group, "lexTape + parseNumbers", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    JsonParser parser(JsonLexer::Options{true});
+    reportLexer(group, "JsonParser + handler", input.size(), [&]() {
+      SumHandler handler;
+      parser.parse(input, handler);
+      sink = handler.values;
+    });
+    reportLexer(group, "JsonDocument reused", input.size(), [&]() {
+      reused.parse(input);
+      sink = reused.root().size();
+    });
+    reportLexer(group, "JsonDocument fresh", input.size(), [&]() {
+      JsonDocument document;
+      document.parse(input);
+      sink = document.root().size();
+    });
+    JsonTape flat;
+    reportLexer(group, "JsonTape", input.size(), [&]() {
+      flat.parse(input);
+      sink = flat.tape.size();
+    });
+    StructuralIndex index;
+    reportLexer(group, "index + JsonTape", input.size(), [&]() {
+      index.build(input);
+      flat.parse(input, index);
+      sink = flat.tape.size();
+    });
+    spdlog::info("{:<24} arena {:.1f} MB for {:.1f} MB of input", group, reused.memoryUsage() / 1e6,
+                 input.size() / 1e6);
+    spdlog::info("{:<24} tape {:.1f} MB + strings {:.1f} MB", group,
+                 flat.tape.capacity() * sizeof(uint64_t) / 1e6, flat.strings.capacity() / 1e6);
+
+    // 在建好的文档上查询：每条记录按 key 找一个字段，JsonTape 跳过前面的成员只需一次跳转
+    group = "query/" + std::string(name);
+    reportLexer(group, "JsonDocument find", input.size(), [&]() {
+      double total = 0;
+      for (const auto& record : reused.root().elements()) total += record.find("score")->toDouble();
+      sink = static_cast<size_t>(total);
+    });
+    reportLexer(group, "JsonTape find", input.size(), [&]() {
+      double total = 0;
+      for (auto record : flat.root()) total += record.find("score").toDouble();
+      sink = static_cast<size_t>(total);
+    });
+    // 访问全部节点：JsonDocument 用显式的栈，JsonTape 顺序扫描
+    reportLexer(group, "JsonDocument walk", input.size(), [&]() {
+      size_t nodes = 0;
+      std::vector<const JsonValue*> stack{&reused.root()};
+      while (!stack.empty()) {
+        auto value = stack.back();
+        stack.pop_back();
+        ++nodes;
+        if (value->type() == JsonType::ARRAY) {
+          for (const auto& element : value->elements()) stack.push_back(&element);
+        } else if (value->type() == JsonType::OBJECT) {
+          nodes += value->size();  // key 也算一个节点，与 tape 一致
+          for (const auto& member : value->members()) stack.push_back(&member.value);
+        }
+      }
+      sink = nodes;
+    });
+    reportLexer(group, "JsonTape walk", input.size(), [&]() {
+      size_t nodes = 0;
+      for (size_t k = 0; k < flat.tape.size(); ++k) {
+        switch (JsonTape::typeOf(flat.tape[k])) {
+          case 'l':
+          case 'u':
+          case 'd':
+            ++k;
+            break;
+          case '}':
+          case ']':
+            continue;
+        }
+        ++nodes;
+      }
+      sink = nodes;
+    });
+  }
+
+  // 稀疏访问：在几十 KB 的文档中只读几个字段，对比完整分析和按需访问
+  // 单个文档太小，每轮重复 REPEAT 次，吞吐量按整个文档的字节数计算
+  void benchOnDemand(std::string_view name, std::string_view input) {
+    constexpr int REPEAT = 200;
+    std::string group = "ondemand/" + std::string(name);
+    size_t bytes = input.size() * REPEAT;
+    JsonLexer lexer(JsonLexer::Options{true});
+    TokenTape tape;
+    reportLexer(group, "lexTape (all tokens)", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    JsonDocument document;
+    reportLexer(group, "JsonDocument + find", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) {
+        document.parse(input);
+        const auto& root = document.root();
+        double total = root[0].find("id")->toDouble() + root[150].find("score")->toDouble() +
+                       root[100].find("location")->find("lat")->toDouble();
+        sink = static_cast<size_t>(total) + root[20].find("name")->string().size();
+      }
+    });
+    JsonOnDemand lazy;
+    reportLexer(group, "JsonOnDemand", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) {
+        lazy.parse(input);
+        auto root = lazy.root();
+        int64_t id = 0;
+        double score = 0, lat = 0;
+        std::string_view userName;
+        root[0]["id"].getInt64(id);
+        root[150]["score"].getDouble(score);
+        root[100]["location"]["lat"].getDouble(lat);
+        root[20]["name"].getString(userName);
+        sink = static_cast<size_t>(id + score + lat) + userName.size();
+      }
+    });
+    JsonOnDemand matched(JsonOnDemand::Options{true});
+    reportLexer(group, "JsonOnDemand + matchBrackets", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) {
+        matched.parse(input);
+        auto root = matched.root();
+        int64_t id = 0;
+        double score = 0, lat = 0;
+        std::string_view userName;
+        root[0]["id"].getInt64(id);
+        root[150]["score"].getDouble(score);
+        root[100]["location"]["lat"].getDouble(lat);
+        root[20]["name"].getString(userName);
+        sink = static_cast<size_t>(id + score + lat) + userName.size();
+      }
+    });
+
+    // 同一份输入建好索引之后反复查询：按深度数括号与查配对表对比，只计查询本身
+    auto queries = [&](JsonOnDemand& doc) {
+      double total = 0;
+      for (size_t k = 0; k < 150; k += 3) {
+        double lat = 0;
+        doc.root()[k]["location"]["lat"].getDouble(lat);
+        total += lat;
+      }
+      sink = static_cast<size_t>(total);
+    };
+    lazy.parse(input);
+    matched.parse(input);
+    reportLexer(group, "50 queries, depth scan", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) queries(lazy);
+    });
+    reportLexer(group, "50 queries, matched", bytes, [&]() {
+      for (int k = 0; k < REPEAT; ++k) queries(matched);
+    });
+  }
+
+  // 跳过整个根数组：只数括号深度的各内核与完整的词法分析对比
+  void benchSkip(std::string_view name, std::string_view input) {
+    std::string group = "skip/" + std::string(name);
+    const char* begin = input.data() + 1;
+    const char* end = input.data() + input.size();
+    JsonLexer lexer;
+    TokenTape tape;
+    reportLexer(group, "lexTape", input.size(), [&]() {
+      lexer.lexTape(input, tape);
+      sink = tape.tokens.size();
+    });
+    reportLexer(group, "skipContainer bytewise", input.size(), [&]() {
+      sink = simd::skipContainerBytewise(begin, end, 1) - input.data();
+    });
+#if JSON_SIMD_X86
+    reportLexer(group, "skipContainer sse4.2", input.size(), [&]() {
+      sink = simd::skipContainerSse42(begin, end, 1) - input.data();
+    });
+    reportLexer(group, "skipContainer avx2", input.size(), [&]() {
+      sink = simd::skipContainerAvx2(begin, end, 1) - input.data();
+    });
+#endif
+  }
+
+  // 冷启动：重新分析 JSON 与映射保存好的 tape 文件对比，吞吐量按 JSON 的字节数计算
+  // 文件刚写过，在页缓存中，这里量的是不含磁盘读取的部分
+  void benchTapeFile(std::string_view name, std::string_view input) {
+    std::string group = "tapefile/" + std::string(name);
+    const char* path = "json-parser-bench.tape";
+    JsonTape tape;
+    reportLexer(group, "JsonTape parse", input.size(), [&]() {
+      tape.parse(input);
+      sink = tape.tape.size();
+    });
+    if (TapeFile::save(tape, path)) {
+      spdlog::info("{:<24} 无法写入 {}", group, path);
+      return;
+    }
+    TapeFile file;
+    reportLexer(group, "TapeFile open + verify", input.size(), [&]() {
+      file.open(path);
+      sink = file.root().size();
+    });
+    reportLexer(group, "TapeFile open", input.size(), [&]() {
+      file.open(path, false);
+      sink = file.root().size();
+    });
+    file.close();
+    std::remove(path);
+  }
+
+  // 同一份语料上对比状态机的两种分派方式
+  void benchDispatch(std::string_view name, std::string_view input) {
+    JsonLexer lexer;
+    TokenTape tape;
+    std::string group = "dispatch/" + std::string(name);
+    reportLexer(group, "switch", input.size(), [&]() {
+      lexer.lexTape<JsonLexer::Dispatch::SWITCH>(input, tape);
+      sink = tape.tokens.size();
+    });
+#if JSON_LEXER_HAS_COMPUTED_GOTO
+    reportLexer(group, "computed goto", input.size(), [&]() {
+      lexer.lexTape<JsonLexer::Dispatch::COMPUTED_GOTO>(input, tape);
+      sink = tape.tokens.size();
+    });
+#endif
+  }
+}
+
+int main() {
+  auto minified = corpus::records(16 << 20, false);
+  auto pretty = corpus::records(16 << 20, true);
+
+  benchWhitespace("minified", minified);
+  benchWhitespace("pretty", pretty);
+
+  benchDispatch("minified", minified);
+  benchDispatch("pretty", pretty);
+
+  benchNumbers("ids", corpus::numbers(16 << 20, 19, 0));
+  benchNumbers("timestamps", corpus::numbers(16 << 20, 13, 0));
+  benchNumbers("doubles", corpus::numbers(16 << 20, 3, 14));
+
+  benchStrings("records", minified);
+  benchStrings("ascii", corpus::texts(16 << 20, false));
+  benchStrings("cjk", corpus::texts(16 << 20, true));
+
+  benchUnescape("records", minified);
+  benchUnescape("cjk escaped", corpus::texts(16 << 20, true, true));
+
+  benchDocument("minified", minified);
+  benchDocument("pretty", pretty);
+
+  benchTapeFile("minified", minified);
+
+  benchSkip("minified", minified);
+  benchSkip("pretty", pretty);
+
+  benchOnDemand("50 KB records", corpus::records(50 << 10, false));
+}
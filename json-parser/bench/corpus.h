@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 基准测试用的合成语料，固定随机种子，每次生成的内容相同
+namespace corpus {
+  class JsonWriter {
+    private:
+      std::string out;
+      bool pretty;
+      // 每一层是否已经写过元素，决定是否需要逗号
+      std::vector<bool> hasElement;
+      bool afterKey = false;
+
+      void newline() {
+        if (!pretty) return;
+        out += '\n';
+        out.append(hasElement.size() * 2, ' ');
+      }
+
+      void beforeValue() {
+        if (afterKey) {
+          afterKey = false;
+          return;
+        }
+        if (hasElement.empty()) return;
+        if (hasElement.back()) out += ',';
+        hasElement.back() = true;
+        newline();
+      }
+
+      void open(char c) {
+        beforeValue();
+        out += c;
+        hasElement.push_back(false);
+      }
+
+      void close(char c) {
+        bool empty = !hasElement.back();
+        hasElement.pop_back();
+        if (!empty) newline();
+        out += c;
+      }
+
+    public:
+      explicit JsonWriter(bool pretty) : pretty(pretty) {}
+
+      void beginObject() { open('{'); }
+      void endObject() { close('}'); }
+      void beginArray() { open('['); }
+      void endArray() { close(']'); }
+
+      void key(std::string_view k) {
+        beforeValue();
+        out += '"';
+        out += k;
+        out += pretty ? "\": " : "\":";
+        afterKey = true;
+      }
+
+      // 写入一个已经是合法 JSON 文本的值
+      void raw(std::string_view value) {
+        beforeValue();
+        out += value;
+      }
+
+      void string(std::string_view value) {
+        beforeValue();
+        out += '"';
+        out += value;
+        out += '"';
+      }
+
+      size_t size() const { return out.size(); }
+      std::string take() { return std::move(out); }
+  };
+
+  // 类似接口日志的记录数组，约 bytes 字节
+  inline std::string records(size_t bytes, bool pretty) {
+    std::mt19937_64 rng(42);
+    auto word = [&](size_t n) {
+      std::string s;
+      for (size_t k = 0; k < n; ++k) s += static_cast<char>('a' + rng() % 26);
+      return s;
+    };
+
+    JsonWriter writer(pretty);
+    writer.beginArray();
+    while (writer.size() < bytes) {
+      writer.beginObject();
+      writer.key("id");
+      writer.raw(std::to_string(rng() % 10000000000ULL));
+      writer.key("name");
+      writer.string(word(4 + rng() % 12));
+      writer.key("email");
+      writer.string(word(8) + "@example.com");
+      writer.key("active");
+      writer.raw(rng() % 2 ? "true" : "false");
+      writer.key("score");
+      writer.raw(std::to_string(rng() % 10000) + "." + std::to_string(rng() % 100));
+      writer.key("tags");
+      writer.beginArray();
+      for (size_t k = rng() % 4; k > 0; --k) writer.string(word(5));
+      writer.endArray();
+      writer.key("location");
+      writer.beginObject();
+      writer.key("lat");
+      writer.raw("31.2304");
+      writer.key("lon");
+      writer.raw("-121.4737");
+      writer.endObject();
+      writer.key("message");
+      writer.string("User " + word(6) + " logged in from \\\"" + word(10) + "\\\"\\n");
+      writer.key("parent");
+      writer.raw("null");
+      writer.endObject();
+    }
+    writer.endArray();
+    return writer.take();
+  }
+
+  // 约 bytes 字节的数值数组，每个数有 intDigits 位整数和 fractionDigits 位小数（为 0 时是整数），
+  // 用来模拟 ID、时间戳、高精度坐标这类成段数字很长的数据
+  inline std::string numbers(size_t bytes, int intDigits, int fractionDigits) {
+    std::mt19937_64 rng(42);
+    auto digits = [&](int n, bool leading) {
+      std::string s;
+      for (int k = 0; k < n; ++k) {
+        s += static_cast<char>(k == 0 && leading ? '1' + rng() % 9 : '0' + rng() % 10);
+      }
+      return s;
+    };
+
+    JsonWriter writer(false);
+    writer.beginArray();
+    while (writer.size() < bytes) {
+      auto value = digits(intDigits, true);
+      if (fractionDigits > 0) value += "." + digits(fractionDigits, false);
+      writer.raw(value);
+    }
+    writer.endArray();
+    return writer.take();
+  }
+
+  // 约 bytes 字节的字符串数组，每个字符串 20~200 个字符；cjk 为 true 时是 3 字节的汉字，
+  // 偶尔夹一个 4 字节的 emoji，否则是 ASCII 单词，用来比较字符串内容校验在两种文本上的开销
+  // escaped 为 true 时非 ASCII 字符写成 \uXXXX 转义，emoji 写成代理对，即 ASCII 安全的序列化结果
+  inline std::string texts(size_t bytes, bool cjk, bool escaped = false) {
+    std::mt19937_64 rng(42);
+    auto character = [&](std::string& s) {
+      if (!cjk) {
+        s += rng() % 6 == 0 ? ' ' : static_cast<char>('a' + rng() % 26);
+        return;
+      }
+      if (rng() % 50 == 0) {
+        s += escaped ? "\\ud83d\\ude00" : "\xF0\x9F\x98\x80";
+        return;
+      }
+      // U+4E00..U+9FFF
+      uint32_t cp = 0x4E00 + static_cast<uint32_t>(rng() % 0x5200);
+      if (escaped) {
+        static constexpr char hex[] = "0123456789abcdef";
+        s += "\\u";
+        for (int shift = 12; shift >= 0; shift -= 4) s += hex[(cp >> shift) & 0xF];
+        return;
+      }
+      s += static_cast<char>(0xE0 | (cp >> 12));
+      s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      s += static_cast<char>(0x80 | (cp & 0x3F));
+    };
+
+    JsonWriter writer(false);
+    writer.beginArray();
+    while (writer.size() < bytes) {
+      std::string value;
+      for (size_t k = 20 + rng() % 181; k > 0; --k) character(value);
+      writer.string(value);
+    }
+    writer.endArray();
+    return writer.take();
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 单调分配的内存池：按块向系统申请，块内顺着指针往后切，单个对象不单独释放，也不调用析构函数
+// clear 只把指针拨回第一块，已申请的块留着复用；所有块在析构时一起归还
+class Arena {
+  private:
+    struct Block {
+      Block* next;
+      size_t size;  // 块头之后可用的字节数
+
+      char* data() {
+        return reinterpret_cast<char*>(this + 1);
+      }
+    };
+
+    static constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    Block* head = nullptr;     // 第一块，块按申请的顺序串成链表
+    Block* current = nullptr;  // 正在切分的块
+    uintptr_t cursor = 0;
+    uintptr_t limit = 0;
+
+    void use(Block* block) {
+      current = block;
+      cursor = reinterpret_cast<uintptr_t>(block->data());
+      limit = cursor + block->size;
+    }
+
+    // 当前块放不下：先沿链表找 clear 之前留下的块，都放不下再申请新块，
+    // 新块至少是上一块的两倍，块数只随总用量对数增长
+    void* allocateSlow(size_t bytes, size_t align) {
+      while (current != nullptr && current->next != nullptr) {
+        use(current->next);
+        uintptr_t p = (cursor + align - 1) & ~(align - 1);
+        if (p + bytes <= limit) {
+          cursor = p + bytes;
+          return reinterpret_cast<void*>(p);
+        }
+      }
+
+      size_t size = current == nullptr ? MIN_BLOCK_SIZE : current->size * 2;
+      if (size < bytes + align) size = bytes + align;
+      auto block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+      block->next = nullptr;
+      block->size = size;
+      if (current == nullptr) {
+        head = block;
+      } else {
+        current->next = block;
+      }
+      use(block);
+      uintptr_t p = (cursor + align - 1) & ~(align - 1);
+      cursor = p + bytes;
+      return reinterpret_cast<void*>(p);
+    }
+
+  public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept {
+      *this = std::move(other);
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+      std::swap(head, other.head);
+      std::swap(current, other.current);
+      std::swap(cursor, other.cursor);
+      std::swap(limit, other.limit);
+      return *this;
+    }
+
+    ~Arena() {
+      while (head != nullptr) {
+        auto next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+
+    // align 必须是 2 的幂，且不超过 alignof(std::max_align_t)
+    void* allocate(size_t bytes, size_t align) {
+      uintptr_t p = (cursor + align - 1) & ~(align - 1);
+      if (p + bytes <= limit && current != nullptr) {
+        cursor = p + bytes;
+        return reinterpret_cast<void*>(p);
+      }
+      return allocateSlow(bytes, align);
+    }
+
+    // 未初始化的 n 个 T，只能放不需要析构的类型；n 为 0 时返回 nullptr
+    template <typename T>
+    T* allocateArray(size_t n) {
+      static_assert(std::is_trivially_destructible_v<T>, "arena 中的对象不会被析构");
+      if (n == 0) return nullptr;
+      return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    // 之前分配的内存全部作废，与分配过多少对象无关
+    void clear() {
+      if (head != nullptr) use(head);
+    }
+
+    // 已经向系统申请的字节数
+    size_t capacity() const {
+      size_t total = 0;
+      for (auto block = head; block != nullptr; block = block->next) total += block->size;
+      return total;
+    }
+};
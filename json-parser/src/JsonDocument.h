@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Arena.h"
+#include "JsonLexer.h"
+#include "JsonParser.h"
+
+enum class JsonType : uint8_t {
+  NULL_VALUE,
+  BOOLEAN,
+  NUMBER,
+  STRING,
+  ARRAY,
+  OBJECT,
+};
+
+struct JsonMember;
+
+// DOM 的节点，16 字节，没有虚表也不单独分配内存
+// 字符串（已解码）、数组元素和对象成员都放在所属 JsonDocument 的 arena 中，节点只记指针和长度，
+// 文档析构或者重新 parse 之后失效
+class JsonValue {
+  friend class JsonDocument;
+
+  private:
+    JsonType valueType = JsonType::NULL_VALUE;
+    NumberKind kind = NumberKind::RAW;
+    uint32_t length = 0;  // STRING 的字节数，ARRAY 的元素个数，OBJECT 的成员个数
+    union {
+      uint64_t payload = 0;  // BOOLEAN：0/1；NUMBER：见 NumberKind
+      const char* stringChars;
+      const JsonValue* arrayElements;
+      const JsonMember* objectMembers;
+    };
+
+  public:
+    template <typename T>
+    struct Range {
+      const T* first;
+      const T* last;
+
+      const T* begin() const {
+        return first;
+      }
+
+      const T* end() const {
+        return last;
+      }
+
+      size_t size() const {
+        return last - first;
+      }
+    };
+
+    JsonType type() const {
+      return valueType;
+    }
+
+    bool isNull() const {
+      return valueType == JsonType::NULL_VALUE;
+    }
+
+    // 以下访问函数由调用方确保类型正确，与 TokenTape 的同名函数一致
+
+    bool boolean() const {
+      return payload != 0;
+    }
+
+    NumberKind numberKind() const {
+      return kind;
+    }
+
+    // numberKind 是 INT64
+    int64_t int64() const {
+      return static_cast<int64_t>(payload);
+    }
+
+    // numberKind 是 UINT64，或者是非负的 INT64
+    uint64_t uint64() const {
+      return payload;
+    }
+
+    double toDouble() const {
+      return number::toDouble(kind, payload);
+    }
+
+    std::string_view string() const {
+      return {stringChars, length};
+    }
+
+    // ARRAY 的元素个数或 OBJECT 的成员个数
+    size_t size() const {
+      return length;
+    }
+
+    Range<JsonValue> elements() const {
+      return {arrayElements, arrayElements + length};
+    }
+
+    const JsonValue& operator[](size_t k) const {
+      return arrayElements[k];
+    }
+
+    inline Range<JsonMember> members() const;
+
+    // 按顺序比较 key，有重复的 key 时返回第一个，没有时返回 nullptr
+    inline const JsonValue* find(std::string_view key) const;
+};
+
+struct JsonMember {
+  JsonValue key;  // 总是 STRING
+  JsonValue value;
+};
+
+static_assert(sizeof(JsonValue) == 16);
+static_assert(std::is_trivially_copyable_v<JsonValue>);
+
+JsonValue::Range<JsonMember> JsonValue::members() const {
+  return {objectMembers, objectMembers + length};
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const {
+  for (const auto& member : members()) {
+    if (member.key.string() == key) return &member.value;
+  }
+  return nullptr;
+}
+
+// 在 JsonParser 的事件上建立 DOM：用显式的栈代替递归，嵌套再深也不会栈溢出；
+// 所有节点、字符串和数组都从同一个 arena 分配，没有逐节点的 new，释放整个文档也不逐个析构
+//
+//   JsonDocument doc;
+//   if (auto error = doc.parse(input)) { ... error.message(input) ... }
+//   auto name = doc.root().find("name")->string();
+class JsonDocument {
+  friend class JsonParser;
+
+  public:
+    using ErrorCode = JsonParser::ErrorCode;
+    using Error = JsonParser::Error;
+
+  private:
+    // 还没有闭合的数组或对象
+    struct Frame {
+      size_t start;  // 第一个成员在 pending 中的下标
+      bool object;
+    };
+
+    JsonParser parser{JsonLexer::Options{true}};
+    Arena arena;
+    JsonValue rootValue;
+    // 以下只在 parse 期间使用，跨 parse 复用已经扩好的容量
+    std::vector<Frame> stack;
+    // 各层未闭合容器已经完成的成员，数组的成员只用 value；闭合时整段拷进 arena
+    std::vector<JsonMember> pending;
+    // 回调返回 false 的原因
+    const char* abortReason = nullptr;
+
+    // 长度放不进 uint32 时返回 false
+    bool makeString(std::string_view text, JsonValue& value) {
+      if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        abortReason = "字符串超过 uint32 的范围";
+        return false;
+      }
+      auto chars = arena.allocateArray<char>(text.size());
+      if (!text.empty()) std::memcpy(chars, text.data(), text.size());
+      value.valueType = JsonType::STRING;
+      value.length = static_cast<uint32_t>(text.size());
+      value.stringChars = chars;
+      return true;
+    }
+
+    // 一个值完成了：没有未闭合的容器时就是根，否则成为栈顶容器的成员
+    void store(const JsonValue& value) {
+      if (stack.empty()) {
+        rootValue = value;
+      } else if (stack.back().object) {
+        // key 已经先放进了 pending
+        pending.back().value = value;
+      } else {
+        pending.push_back({JsonValue(), value});
+      }
+    }
+
+    // 栈顶容器闭合：成员个数已知，一次分配恰好的空间
+    bool close(size_t n) {
+      if (n > std::numeric_limits<uint32_t>::max()) {
+        abortReason = "数组或对象的成员超过 uint32 的范围";
+        return false;
+      }
+      auto frame = stack.back();
+      JsonValue value;
+      value.length = static_cast<uint32_t>(n);
+      if (frame.object) {
+        auto members = arena.allocateArray<JsonMember>(n);
+        if (n != 0) std::memcpy(members, pending.data() + frame.start, n * sizeof(JsonMember));
+        value.valueType = JsonType::OBJECT;
+        value.objectMembers = members;
+      } else {
+        auto elements = arena.allocateArray<JsonValue>(n);
+        for (size_t k = 0; k < n; ++k) elements[k] = pending[frame.start + k].value;
+        value.valueType = JsonType::ARRAY;
+        value.arrayElements = elements;
+      }
+      pending.resize(frame.start);
+      stack.pop_back();
+      store(value);
+      return true;
+    }
+
+    // JsonParser 的回调
+
+    bool onObjectStart() {
+      stack.push_back({pending.size(), true});
+      return true;
+    }
+
+    bool onArrayStart() {
+      stack.push_back({pending.size(), false});
+      return true;
+    }
+
+    bool onObjectEnd(size_t count) {
+      return close(count);
+    }
+
+    bool onArrayEnd(size_t count) {
+      return close(count);
+    }
+
+    bool onKey(std::string_view key) {
+      JsonValue value;
+      if (!makeString(key, value)) return false;
+      pending.push_back({value, JsonValue()});
+      return true;
+    }
+
+    bool onString(std::string_view text) {
+      JsonValue value;
+      if (!makeString(text, value)) return false;
+      store(value);
+      return true;
+    }
+
+    bool onNumber(const TapeToken& token, std::string_view) {
+      JsonValue value;
+      value.valueType = JsonType::NUMBER;
+      value.kind = TokenTape::numberKind(token);
+      value.payload = token.payload;
+      store(value);
+      return true;
+    }
+
+    bool onBool(bool flag) {
+      JsonValue value;
+      value.valueType = JsonType::BOOLEAN;
+      value.payload = flag;
+      store(value);
+      return true;
+    }
+
+    bool onNull() {
+      store(JsonValue());
+      return true;
+    }
+
+  public:
+    JsonDocument() = default;
+
+    // 替换掉之前的内容，之前取得的 JsonValue 全部失效；旧文档的内存整块回收复用
+    // 出错时文档为空；成员个数或者字符串的长度超出 uint32 时是 ErrorCode::ABORTED，原因见 Error::reason
+    Error parse(std::string_view input) {
+      arena.clear();
+      rootValue = JsonValue();
+      stack.clear();
+      pending.clear();
+      abortReason = nullptr;
+
+      auto error = parser.parse(input, *this);
+      if (error) {
+        rootValue = JsonValue();
+        if (error.code == ErrorCode::ABORTED) error.reason = abortReason;
+      }
+      return error;
+    }
+
+    // 没有 parse 过或者 parse 出错时是 null
+    const JsonValue& root() const {
+      return rootValue;
+    }
+
+    // arena 已经向系统申请的字节数
+    size_t memoryUsage() const {
+      return arena.capacity();
+    }
+};
@@ -1,14 +1,48 @@
 #pragma once
 
+#include <array>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "Token.h"
+#include "StructuralIndex.h"
+#include "TokenTape.h"
+#include "number.h"
+#include "simd.h"
 #include "spdlog/spdlog.h"
 #include "util.h"
 
+#if defined(__GNUC__)
+  #define JSON_LEXER_HAS_COMPUTED_GOTO 1
+#else
+  #define JSON_LEXER_HAS_COMPUTED_GOTO 0
+#endif
+
+// 状态机中每个 case 同时带一个标号，供 computed goto 直接跳转；
+// 每个 case 以 JSON_LEXER_NEXT() 结束：switch 版本回到循环顶部，computed goto 版本读入下一个字符后
+// 直接跳到新状态的标号，读完时退出 switch，由循环条件结束
+#if JSON_LEXER_HAS_COMPUTED_GOTO
+  #define JSON_LEXER_CASE(name) \
+    case State::name:           \
+    TARGET_##name
+  #define JSON_LEXER_NEXT()                          \
+    if constexpr (threaded) {                        \
+      if (i < end) {                                 \
+        c = input[i++];                              \
+        goto* targets[static_cast<size_t>(state)];   \
+      }                                              \
+    }                                                \
+    break
+#else
+  #define JSON_LEXER_CASE(name) case State::name
+  #define JSON_LEXER_NEXT() break
+#endif
+
 class JsonLexer {
-  private:
+  public:
   enum class State {
     INIT,
     IN_STRING,
@@ -20,364 +54,991 @@ class JsonLexer {
     AFTER_HIGH_SURROGATE,
     BEFORE_LOW_SURROGATE,
     IN_LOW_SURROGATE,
+    IN_UTF8_SEQUENCE,
 
+    // 数值的各个状态必须连续排列，它们是 numberTable 的行下标
     AFTER_NUMBER_INTEGER_SIGN,
     AFTER_NUMBER_LEADING_ZERO,
     IN_NUMBER_INTEGER,
-    AFTER_NUMBER_INTEGER,
     AFTER_NUMBER_POINT,
     IN_NUMBER_FRACTION_DIGIT,
-    AFTER_NUMBER_FRACTION,
     IN_NUMBER_EXPONENT,
     AFTER_NUMBER_EXPONENT_SIGN,
     IN_NUMBER_EXPONENT_DIGIT,
+
+    // 不是真正的状态，只出现在转移表中，表示遇到了非法字符
+    INVALID,
+  };
+
+  enum class ErrorCode : uint8_t {
+    NONE,
+    UNKNOWN_CHARACTER,
+    INVALID_NUMBER,
+    INVALID_ESCAPE,
+    INVALID_UNICODE_ESCAPE,
+    MISSING_HIGH_SURROGATE,
+    MISSING_LOW_SURROGATE,
+    NOT_LOW_SURROGATE,
+    INCOMPLETE_UNICODE_ESCAPE,
+    UNPAIRED_SURROGATE,
+    INCOMPLETE_NUMBER,
+    INCOMPLETE_KEYWORD,
+    UNCLOSED_STRING,
+    INVALID_UTF8,
+    CONTROL_CHARACTER,
+  };
+
+  // 分析的结果：出错时记录错误码、出错的位置和当时的状态，成功时 code 为 NONE
+  // 本身不持有任何字符串，可读的提示只在调用 message 时才生成
+  struct Error {
+    ErrorCode code = ErrorCode::NONE;
+    State state = State::INIT;
+    // 非法字符的偏移；输入提前结束的错误是未完成 token 的起始偏移，
+    // 不完整的 unicode 转义是其十六进制数字的起始偏移
+    size_t offset = 0;
+
+    explicit operator bool() const {
+      return code != ErrorCode::NONE;
+    }
+
+    // 错误的种类，不涉及出错处的内容，不分配内存
+    const char* what() const {
+      switch (code) {
+        case ErrorCode::NONE:
+          return "";
+        case ErrorCode::UNKNOWN_CHARACTER:
+          return "未知的字符";
+        case ErrorCode::INVALID_NUMBER:
+        case ErrorCode::INCOMPLETE_NUMBER:
+          return "非法的数值";
+        case ErrorCode::INVALID_ESCAPE:
+          return "未知的转义字符";
+        case ErrorCode::INVALID_UNICODE_ESCAPE:
+          return "未知的 unicode 转义字符";
+        case ErrorCode::MISSING_HIGH_SURROGATE:
+          return "低位代理缺少高位代理";
+        case ErrorCode::MISSING_LOW_SURROGATE:
+          return "高位代理后必须紧跟低位代理";
+        case ErrorCode::NOT_LOW_SURROGATE:
+          return "高位代理后的码点不是低位代理";
+        case ErrorCode::INCOMPLETE_UNICODE_ESCAPE:
+          return "不完整的 unicode 转义序列";
+        case ErrorCode::UNPAIRED_SURROGATE:
+          return "未配对的 unicode 转义序列";
+        case ErrorCode::INCOMPLETE_KEYWORD:
+          return "不全的关键字";
+        case ErrorCode::UNCLOSED_STRING:
+          return "未闭合的字符串";
+        case ErrorCode::INVALID_UTF8:
+          return "非法的 UTF-8 序列";
+        case ErrorCode::CONTROL_CHARACTER:
+          return "字符串中有未转义的控制字符";
+      }
+      return "";
+    }
+
+    // input 是出错的输入，用来取出错处的内容；offset 不在 input 范围内时只给出错误的种类
+    std::string message(std::string_view input = {}) const {
+      if (offset >= input.size()) return what();
+      auto rest = input.substr(offset);
+      char c = input[offset];
+      // 码点错误的 offset 指向四位十六进制数字
+      auto codePoint = [&]() {
+        return util::strToCodePoint(rest.substr(0, 4));
+      };
+
+      switch (code) {
+        case ErrorCode::UNKNOWN_CHARACTER:
+          return fmt::format("未知的字符：{}", c);
+        case ErrorCode::INVALID_NUMBER:
+          switch (state) {
+            case State::AFTER_NUMBER_INTEGER_SIGN:
+              return fmt::format("负号后面紧跟的不是数字：{}", c);
+            case State::AFTER_NUMBER_LEADING_ZERO: {
+              // 前导零之前最多还有一个负号
+              size_t start = offset - 1;
+              if (start > 0 && input[start - 1] == '-') start--;
+              return fmt::format("前导零非法：{}", input.substr(start, offset + 1 - start));
+            }
+            case State::AFTER_NUMBER_POINT:
+              return fmt::format("小数点后面紧跟的不是数字：{}", c);
+            default:
+              return fmt::format("非数字：{}", c);
+          }
+        case ErrorCode::INVALID_ESCAPE:
+          return fmt::format("未知的转义字符：{}", c);
+        case ErrorCode::INVALID_UNICODE_ESCAPE:
+          return fmt::format("未知的 unicode 转义字符：{}", c);
+        case ErrorCode::INVALID_UTF8:
+        case ErrorCode::CONTROL_CHARACTER:
+          // 这些字节无法原样打印
+          return fmt::format("{}：{:#04x}", what(), static_cast<uint8_t>(c));
+        case ErrorCode::MISSING_HIGH_SURROGATE:
+          return fmt::format("码点 {:#x} 缺少高位代理", codePoint());
+        case ErrorCode::NOT_LOW_SURROGATE:
+          return fmt::format("码点 {:#x} 不是低位代理", codePoint());
+        case ErrorCode::INCOMPLETE_UNICODE_ESCAPE:
+        case ErrorCode::INCOMPLETE_NUMBER:
+        case ErrorCode::INCOMPLETE_KEYWORD:
+        case ErrorCode::UNCLOSED_STRING:
+          // 输入提前结束，offset 之后就是未完成的部分
+          return fmt::format("{}：{}", what(), rest);
+        default:
+          return what();
+      }
+    }
   };
 
+  struct Options {
+    // 在分析数值的同时把它转换成 int64/uint64/double，结果记在 token 的 flags 和 payload 中，
+    // 见 NumberKind；关闭时只校验文法、记录位置，需要时再用 TokenTape::materialize 转换
+    bool parseNumbers = false;
+    // 整数照常解析，带小数点或指数的数精确地保存成十进制尾数和指数，不转换成 double，
+    // 见 NumberKind::DECIMAL；与 parseNumbers 同时开启时以此为准
+    bool exactDecimals = false;
+    // 检查字符串内容是合法的 UTF-8 且没有未转义的控制字符，与查找字符串结尾的扫描合在一起做；
+    // 确知输入合法时可以关闭，字符串内容原样接受
+    bool validateStrings = true;
+  };
+
+  private:
+  // 状态机在两次调用之间需要保留的状态，token 未完成时输入可以在任意字节处中断
+  struct Context {
+    State state = State::INIT;
+    size_t tokenStart = 0;
+    uint8_t keywordLength = 0;  // 关键字中已经匹配的字符数
+    uint32_t unicodeValue = 0;  // 逐字节分析 \u 转义时已经读到的数字的值
+    uint8_t unicodeDigits = 0;  // 已经读到的数字个数
+    uint32_t highSurrogate = 0;
+    bool hasEscapes = false;
+    simd::Utf8Lead utf8{};  // 未完成的多字节序列还需要的续字节个数和下一个续字节的范围
+    Error error;
+  };
+
+  // 推送模式跨 feed 调用保留的状态
+  Context streamContext;
+  // 跨越 chunk 的未完成 token 在之前各个 chunk 中的字节
+  std::string pending;
+  // 已经 feed 的总字节数，即当前 chunk 在整个输入流中的偏移
+  size_t streamOffset = 0;
+
+  // 推送模式的 sink：offset 相对当前 chunk，转换成整个流中的偏移后连同原始字节交给回调
+  template <typename OnToken>
+  struct StreamSink {
+    std::string_view chunk;
+    size_t base;
+    std::string& pending;
+    OnToken& onToken;
+    const Options& options;
+    size_t count = 0;
+
+    void push(TokenType type, size_t offset, size_t length, uint64_t payload = 0, uint8_t flags = 0) {
+      emit({type, flags, 0, 0, base + offset, payload}, offset, length);
+    }
+
+    void pushString(size_t offset, size_t length, bool hasEscapes) {
+      push(TokenType::STRING, offset, length, 0, hasEscapes ? TapeToken::HAS_ESCAPES : 0);
+    }
+
+    void pushNumber(size_t offset, size_t length, NumberKind kind, uint64_t payload, int16_t exponent) {
+      emit({TokenType::NUMBER, static_cast<uint8_t>(kind), exponent, 0, base + offset, payload},
+           offset,
+           length);
+    }
+
+    size_t size() const {
+      return count;
+    }
+
+    void emit(TapeToken token, size_t offset, size_t length) {
+      std::string_view text = chunk.substr(offset, length);
+      if (!pending.empty()) {
+        // 只有从之前的 chunk 延续过来的 token 才会走到这里，它在本 chunk 中从 0 开始
+        token.offset = base - pending.size();
+        pending.append(text);
+        text = pending;
+        // 词法分析器只看到了数值在本 chunk 中的后半段，用完整的文本重新解析
+        if (token.type == TokenType::NUMBER && token.flags != static_cast<uint8_t>(NumberKind::RAW)) {
+          token.flags = static_cast<uint8_t>(parseNumber(options, text, token.payload, token.exponent));
+        }
+      }
+      token.length = static_cast<uint32_t>(text.size());
+      onToken(static_cast<const TapeToken&>(token), text);
+      pending.clear();
+      ++count;
+    }
+  };
+
+  static constexpr size_t NUMBER_STATE_COUNT =
+    static_cast<size_t>(State::IN_NUMBER_EXPONENT_DIGIT)
+    - static_cast<size_t>(State::AFTER_NUMBER_INTEGER_SIGN) + 1;
+  static constexpr size_t CHAR_CLASS_COUNT = static_cast<size_t>(util::CharClass::COUNT);
+
+  // 数值文法的 状态 × 字符类别 转移表
+  // 转移到 INIT 表示数值在当前字符之前结束，当前字符要在 INIT 中重新处理
+  static State numberTransition(State state, char c) {
+    using CC = util::CharClass;
+    static constexpr auto numberTable = []() {
+      std::array<std::array<State, CHAR_CLASS_COUNT>, NUMBER_STATE_COUNT> table{};
+      auto row = [&](State s) -> auto& {
+        return table[static_cast<size_t>(s) - static_cast<size_t>(State::AFTER_NUMBER_INTEGER_SIGN)];
+      };
+      auto set = [](auto& r, CC cc, State next) { r[static_cast<size_t>(cc)] = next; };
+      for (auto& r : table) {
+        for (auto& next : r) next = State::INVALID;
+      }
+      // 可以作为数值结尾的状态，遇到其他字符时数值结束
+      for (auto s : {State::AFTER_NUMBER_LEADING_ZERO,
+                     State::IN_NUMBER_INTEGER,
+                     State::IN_NUMBER_FRACTION_DIGIT,
+                     State::IN_NUMBER_EXPONENT_DIGIT}) {
+        for (auto& next : row(s)) next = State::INIT;
+      }
+
+      set(row(State::AFTER_NUMBER_INTEGER_SIGN), CC::ZERO, State::AFTER_NUMBER_LEADING_ZERO);
+      set(row(State::AFTER_NUMBER_INTEGER_SIGN), CC::DIGIT, State::IN_NUMBER_INTEGER);
+
+      set(row(State::AFTER_NUMBER_LEADING_ZERO), CC::ZERO, State::INVALID);
+      set(row(State::AFTER_NUMBER_LEADING_ZERO), CC::DIGIT, State::INVALID);
+      set(row(State::AFTER_NUMBER_LEADING_ZERO), CC::POINT, State::AFTER_NUMBER_POINT);
+      set(row(State::AFTER_NUMBER_LEADING_ZERO), CC::EXPONENT, State::IN_NUMBER_EXPONENT);
+
+      set(row(State::IN_NUMBER_INTEGER), CC::ZERO, State::IN_NUMBER_INTEGER);
+      set(row(State::IN_NUMBER_INTEGER), CC::DIGIT, State::IN_NUMBER_INTEGER);
+      set(row(State::IN_NUMBER_INTEGER), CC::POINT, State::AFTER_NUMBER_POINT);
+      set(row(State::IN_NUMBER_INTEGER), CC::EXPONENT, State::IN_NUMBER_EXPONENT);
+
+      set(row(State::AFTER_NUMBER_POINT), CC::ZERO, State::IN_NUMBER_FRACTION_DIGIT);
+      set(row(State::AFTER_NUMBER_POINT), CC::DIGIT, State::IN_NUMBER_FRACTION_DIGIT);
+
+      set(row(State::IN_NUMBER_FRACTION_DIGIT), CC::ZERO, State::IN_NUMBER_FRACTION_DIGIT);
+      set(row(State::IN_NUMBER_FRACTION_DIGIT), CC::DIGIT, State::IN_NUMBER_FRACTION_DIGIT);
+      set(row(State::IN_NUMBER_FRACTION_DIGIT), CC::EXPONENT, State::IN_NUMBER_EXPONENT);
+
+      set(row(State::IN_NUMBER_EXPONENT), CC::MINUS, State::AFTER_NUMBER_EXPONENT_SIGN);
+      set(row(State::IN_NUMBER_EXPONENT), CC::PLUS, State::AFTER_NUMBER_EXPONENT_SIGN);
+      set(row(State::IN_NUMBER_EXPONENT), CC::ZERO, State::IN_NUMBER_EXPONENT_DIGIT);
+      set(row(State::IN_NUMBER_EXPONENT), CC::DIGIT, State::IN_NUMBER_EXPONENT_DIGIT);
+
+      set(row(State::AFTER_NUMBER_EXPONENT_SIGN), CC::ZERO, State::IN_NUMBER_EXPONENT_DIGIT);
+      set(row(State::AFTER_NUMBER_EXPONENT_SIGN), CC::DIGIT, State::IN_NUMBER_EXPONENT_DIGIT);
+
+      set(row(State::IN_NUMBER_EXPONENT_DIGIT), CC::ZERO, State::IN_NUMBER_EXPONENT_DIGIT);
+      set(row(State::IN_NUMBER_EXPONENT_DIGIT), CC::DIGIT, State::IN_NUMBER_EXPONENT_DIGIT);
+      return table;
+    }();
+
+    auto row = static_cast<size_t>(state) - static_cast<size_t>(State::AFTER_NUMBER_INTEGER_SIGN);
+    return numberTable[row][static_cast<size_t>(util::charClass(c))];
+  }
+
   public:
-  std::vector<std::unique_ptr<Token>> lex(const std::string& input) {
+  JsonLexer() = default;
+
+  explicit JsonLexer(Options options)
+      : options(options) {}
+
+  // 状态机的分派方式：switch 是可移植的默认做法；
+  // computed goto 让每个状态直接跳到下一个状态的代码，需要 GCC/Clang 的 labels-as-values 扩展
+  enum class Dispatch {
+    SWITCH,
+    COMPUTED_GOTO,
+  };
+
+#if defined(JSON_LEXER_USE_COMPUTED_GOTO) && JSON_LEXER_HAS_COMPUTED_GOTO
+  static constexpr Dispatch DEFAULT_DISPATCH = Dispatch::COMPUTED_GOTO;
+#else
+  static constexpr Dispatch DEFAULT_DISPATCH = Dispatch::SWITCH;
+#endif
+
+  // 出错时返回出错之前的 token
+  std::vector<std::unique_ptr<Token>> lex(const std::string& input, Error& error) {
+    TokenTape tape;
+    error = lexTape(input, tape);
+
     std::vector<std::unique_ptr<Token>> tokens;
+    tokens.reserve(tape.tokens.size());
+    for (const auto& token : tape.tokens) {
+      tokens.push_back(tape.toToken(token, input));
+    }
+    return tokens;
+  }
 
-    auto state = State::INIT;
-    std::string buffer, unicodeBuffer;
-    unicodeBuffer.reserve(4);
-    size_t i = 0;
-    uint32_t highSurrogate = 0;
-    while (i < input.length()) {
-      char c = input[i++];
-      switch (state) {
-        case State::INIT:
-          if (c == '{') {
-            tokens.push_back(std::make_unique<ObjectStartToken>());
-          } else if (c == '}') {
-            tokens.push_back(std::make_unique<ObjectEndToken>());
-          } else if (c == ':') {
-            tokens.push_back(std::make_unique<ColonToken>());
-          } else if (c == ',') {
-            tokens.push_back(std::make_unique<CommaToken>());
-          } else if (c == '[') {
-            tokens.push_back(std::make_unique<ArrayStartToken>());
-          } else if (c == ']') {
-            tokens.push_back(std::make_unique<ArrayEndToken>());
-          } else if (c == '"') {
-            state = State::IN_STRING;
-          } else if (c == '-') {
-            state = State::AFTER_NUMBER_INTEGER_SIGN;
-            buffer += c;
-          } else if (c == '0') {
-            state = State::AFTER_NUMBER_LEADING_ZERO;
-            buffer += c;
-          } else if (util::isDigit(c)) {
-            state = State::IN_NUMBER_INTEGER;
-            buffer += c;
-          } else if (c == 't') {
-            state = State::IN_TRUE;
-            buffer += c;
-          } else if (c == 'f') {
-            state = State::IN_FALSE;
-            buffer += c;
-          } else if (c == 'n') {
-            state = State::IN_NULL;
-            buffer += c;
-          } else if (util::isBlank(c)) {
-            // skip, do nothing
-          } else {
-            spdlog::info("未知的字符：{}", c);
-            exit(1);
+  // 出错时打印错误并退出程序
+  std::vector<std::unique_ptr<Token>> lex(const std::string& input) {
+    Error error;
+    auto tokens = lex(input, error);
+    if (error) {
+      spdlog::info("{}", error.message(input));
+      exit(1);
+    }
+    return tokens;
+  }
+
+  // 把 token 写入连续的 tape，除 tape 自身扩容外不做逐 token 的堆分配
+  // 字符串只做校验不做解码，tape 中记录的是它在 input 中的位置，需要时再解码
+  // 出错时 tape 中保留出错之前的 token
+  template <Dispatch D = DEFAULT_DISPATCH>
+  Error lexTape(std::string_view input, TokenTape& tape) {
+    tape.clear();
+    Context ctx;
+    lexRange<D>(input, 0, input.length(), ctx, tape);
+    if (!ctx.error) flush(input, input.length(), ctx, tape);
+    return ctx.error;
+  }
+
+  // 第二阶段：只访问 index 给出的结构位置，index 必须由同一个 input 构建
+  // 单字符 token 直接写入 tape，字符串和标量交给状态机分析到下一个结构位置为止
+  template <Dispatch D = DEFAULT_DISPATCH>
+  Error lexTape(std::string_view input, const StructuralIndex& index, TokenTape& tape) {
+    tape.clear();
+    Context ctx;
+    lexIndexRange<D>(input, index, 0, ctx, tape);
+    return ctx.error;
+  }
+
+  // 只分析从 start 开始的一个字符串、数值或关键字，end 是结构索引中它的下一个位置（没有时是输入的长度）
+  // 供按需访问使用：只有真正读取的值才经过状态机
+  template <Dispatch D = DEFAULT_DISPATCH>
+  Error lexValue(std::string_view input, size_t start, size_t end, TokenTape& tape) {
+    tape.clear();
+    Context ctx;
+    lexRange<D>(input, start, end, ctx, tape);
+    if (!ctx.error) flush(input, end, ctx, tape);
+    return ctx.error;
+  }
+
+  // 按需产生 token 的游标：每次只分析出一小批 token，内存占用与输入大小无关，
+  // 调用方可以随时停下不再读取；给出结构索引时按第二阶段的方式只访问索引中的位置
+  //
+  //   for (const auto& token : lexer.cursor(input)) { ... }
+  class Cursor {
+    public:
+      static constexpr size_t BATCH_SIZE = 64;
+
+      class Iterator {
+        private:
+          Cursor* cursor;
+          const TapeToken* token;
+
+        public:
+          using iterator_category = std::input_iterator_tag;
+          using value_type = TapeToken;
+          using difference_type = std::ptrdiff_t;
+          using pointer = const TapeToken*;
+          using reference = const TapeToken&;
+
+          explicit Iterator(Cursor* cursor)
+              : cursor(cursor),
+                token(cursor ? cursor->next() : nullptr) {}
+
+          reference operator*() const {
+            return *token;
           }
-          break;
-        case State::AFTER_NUMBER_INTEGER_SIGN:
-          if (c == '0') {
-            state = State::AFTER_NUMBER_LEADING_ZERO;
-            buffer += c;
-          } else if (util::isDigit(c)) {
-            state = State::IN_NUMBER_INTEGER;
-            buffer += c;
-          } else {
-            spdlog::info("负号后面紧跟的不是数字：{}", c);
-            exit(1);
+
+          pointer operator->() const {
+            return token;
           }
-          break;
-        case State::AFTER_NUMBER_LEADING_ZERO:
-          if (util::isDigit(c)) {
-            spdlog::info("前导零非法：{}{}", buffer, c);
-            exit(1);
-          } else {
-            state = State::AFTER_NUMBER_INTEGER;
-            i--;
+
+          Iterator& operator++() {
+            token = cursor->next();
+            return *this;
           }
-          break;
-        case State::IN_NUMBER_INTEGER:
-          if (util::isDigit(c)) {
-            buffer += c;
-          } else {
-            state = State::AFTER_NUMBER_INTEGER;
-            i--;
+
+          bool operator==(const Iterator& other) const {
+            return token == other.token;
           }
-          break;
-        case State::AFTER_NUMBER_INTEGER:
-          if (c == '.') {
-            state = State::AFTER_NUMBER_POINT;
-            buffer += c;
-          } else if (c == 'e' || c == 'E') {
-            state = State::IN_NUMBER_EXPONENT;
-            buffer += c;
-          } else {
-            state = State::INIT;
-            i--;
-            tokens.push_back(std::make_unique<NumberToken>(buffer));
-            buffer.clear();
+
+          bool operator!=(const Iterator& other) const {
+            return token != other.token;
           }
-          break;
-        case State::AFTER_NUMBER_POINT:
-          if (util::isDigit(c)) {
-            state = State::IN_NUMBER_FRACTION_DIGIT;
-            buffer += c;
+      };
+
+    private:
+      JsonLexer& lexer;
+      std::string_view input;
+      const StructuralIndex* index;
+      size_t position = 0;  // 没有索引时是输入中的偏移，否则是索引的下标
+      Context context;
+      TokenTape batch;
+      size_t nextToken = 0;
+
+    public:
+      Cursor(JsonLexer& lexer, std::string_view input, const StructuralIndex* index = nullptr)
+          : lexer(lexer),
+            input(input),
+            index(index) {
+        batch.tokens.reserve(BATCH_SIZE + 1);
+      }
+
+      // 返回下一个 token，输入结束或出错时返回 nullptr，是否出错由 error 给出；
+      // 返回的指针在下一次调用 next 之前有效
+      const TapeToken* next() {
+        if (nextToken == batch.tokens.size()) {
+          size_t last = index ? index->size() : input.length();
+          if (position == last) return nullptr;
+          batch.clear();
+          nextToken = 0;
+          if (index) {
+            position = lexer.lexIndexRange<DEFAULT_DISPATCH>(input, *index, position, context, batch,
+                                                             BATCH_SIZE);
           } else {
-            spdlog::info("小数点后面紧跟的不是数字：{}", c);
-            exit(1);
+            position = lexer.lexRange<DEFAULT_DISPATCH>(input,
+                                                        position,
+                                                        input.length(),
+                                                        context,
+                                                        batch,
+                                                        BATCH_SIZE);
           }
-          break;
-        case State::IN_NUMBER_FRACTION_DIGIT:
-          if (util::isDigit(c)) {
-            state = State::IN_NUMBER_FRACTION_DIGIT;
-            buffer += c;
-          } else {
-            state = State::AFTER_NUMBER_FRACTION;
-            i--;
+          if (context.error) {
+            // 出错之前的 token 照常返回，之后不再继续分析
+            position = last;
+          } else if (!index && position == last) {
+            lexer.flush(input, position, context, batch);
           }
+          // 剩下的只有空白
+          if (batch.tokens.empty()) return nullptr;
+        }
+        return &batch.tokens[nextToken++];
+      }
+
+      const Error& error() const {
+        return context.error;
+      }
+
+      // 游标所分析的输入，配合 TokenTape::rawString 等读取 token 的内容
+      std::string_view source() const {
+        return input;
+      }
+
+      Iterator begin() {
+        return Iterator(this);
+      }
+
+      Iterator end() {
+        return Iterator(nullptr);
+      }
+  };
+
+  Cursor cursor(std::string_view input) {
+    return Cursor(*this, input);
+  }
+
+  // index 必须由同一个 input 构建，并且在游标使用期间保持不变
+  Cursor cursor(std::string_view input, const StructuralIndex& index) {
+    return Cursor(*this, input, &index);
+  }
+
+  // 推送模式：输入分多次到达时，每到一块就调用 feed，全部到达后调用 finish
+  // token 可以跨越 chunk，每个 token 一完整就调用 onToken(const TapeToken& token, std::string_view text)，
+  // token.offset 是在整个输入流中的偏移，text 是 token 的原始字节（字符串含两端引号），
+  // 只在回调期间有效；含转义的字符串可以用 util::appendUnescaped 解码去掉引号后的部分
+  // 出错后的 feed 不再分析，都返回同一个错误，错误的 offset 也是在整个输入流中的偏移
+  template <typename OnToken>
+  Error feed(std::string_view chunk, OnToken&& onToken) {
+    if (streamContext.error) return streamContext.error;
+    StreamSink<OnToken> sink{chunk, streamOffset, pending, onToken, options};
+    lexRange<DEFAULT_DISPATCH>(chunk, 0, chunk.length(), streamContext, sink);
+    if (streamContext.error) {
+      // 跨越 chunk 的 token 中的偏移可能是负的，按无符号数回绕相加结果仍然正确
+      streamContext.error.offset += streamOffset;
+      return streamContext.error;
+    }
+    if (streamContext.state != State::INIT) {
+      // token 未完成，把它在本 chunk 中的部分留下来，下一个 chunk 中它从偏移 0 继续
+      pending.append(chunk.substr(streamContext.tokenStart));
+      streamContext.tokenStart = 0;
+    }
+    streamOffset += chunk.length();
+    return streamContext.error;
+  }
+
+  // 输入结束，输出最后一个 token（如果还有），之后可以开始一个新的输入流
+  // 返回整个输入流中的第一个错误
+  template <typename OnToken>
+  Error finish(OnToken&& onToken) {
+    auto error = streamContext.error;
+    if (!error) {
+      // 未完成的 token 完整地保存在 pending 中，从它的开头分析到结尾
+      std::string last = std::move(pending);
+      pending.clear();
+      size_t base = streamOffset - last.size();
+      StreamSink<OnToken> sink{last, base, pending, onToken, options};
+      flush(last, last.size(), streamContext, sink);
+      error = streamContext.error;
+      if (error) error.offset += base;
+    }
+    streamContext = Context();
+    pending.clear();
+    streamOffset = 0;
+    return error;
+  }
+
+  private:
+  Options options;
+
+  // 从 index 的第 k 个位置开始分析，每个位置恰好产生一个 token
+  // tape 中的 token 数达到 limit 时停下，返回下一个要分析的位置的下标，否则返回 index.size()
+  // 出错时把错误记在 ctx.error 中并返回出错的位置的下标
+  template <Dispatch D, typename Sink>
+  size_t lexIndexRange(std::string_view input,
+                       const StructuralIndex& index,
+                       size_t k,
+                       Context& ctx,
+                       Sink& tape,
+                       size_t limit = std::numeric_limits<size_t>::max()) {
+    for (; k < index.size(); ++k) {
+      if (tape.size() >= limit) return k;
+      size_t pos = index[k];
+      switch (input[pos]) {
+        case '{':
+          tape.push(TokenType::OBJECT_START, pos, 1);
           break;
-        case State::AFTER_NUMBER_FRACTION:
-          if (c == 'e' || c == 'E') {
-            state = State::IN_NUMBER_EXPONENT;
-            buffer += c;
-          } else {
-            state = State::INIT;
-            i--;
-            tokens.push_back(std::make_unique<NumberToken>(buffer));
-            buffer.clear();
-          }
+        case '}':
+          tape.push(TokenType::OBJECT_END, pos, 1);
           break;
-        case State::IN_NUMBER_EXPONENT:
-          if (c == '-' || c == '+') {
-            state = State::AFTER_NUMBER_EXPONENT_SIGN;
-            buffer += c;
-          } else if(util::isDigit(c)) {
-            state = State::IN_NUMBER_EXPONENT_DIGIT;
-            buffer += c;
-          } else {
-            spdlog::info("非数字：{}", c);
-            exit(1);
-          }
+        case ':':
+          tape.push(TokenType::COLON, pos, 1);
           break;
-        case State::AFTER_NUMBER_EXPONENT_SIGN:
-          if (util::isDigit(c)) {
-            state = State::IN_NUMBER_EXPONENT_DIGIT;
-            buffer += c;
-          } else {
-            spdlog::info("非数字：{}", c);
-            exit(1);
-          }
+        case ',':
+          tape.push(TokenType::COMMA, pos, 1);
           break;
-        case State::IN_NUMBER_EXPONENT_DIGIT:
-          if (util::isDigit(c)) {
-            buffer += c;
-          } else {
+        case '[':
+          tape.push(TokenType::ARRAY_START, pos, 1);
+          break;
+        case ']':
+          tape.push(TokenType::ARRAY_END, pos, 1);
+          break;
+        default: {
+          size_t next = k + 1 < index.size() ? index[k + 1] : input.length();
+          lexRange<D>(input, pos, next, ctx, tape);
+          if (!ctx.error) flush(input, next, ctx, tape);
+          if (ctx.error) return k;
+        }
+      }
+    }
+    return k;
+  }
+
+  // 用状态机分析 input[begin, end)，从 ctx 保存的状态继续，结束时把状态存回 ctx
+  // end 之后可能还有输入，所以不处理结尾处未完成的 token，需要时由调用方调用 flush
+  // sink 中的 token 数达到 limit 时在 token 边界处停下，返回停下的位置，否则返回 end
+  // 出错时把错误记在 ctx.error 中并返回出错的位置
+  //
+  // sink 需要提供 push(type, offset, length, payload)、pushString(offset, length, hasEscapes)
+  // 和 size()，offset 都是相对 input 的，TokenTape 就是一种 sink
+  template <Dispatch D, typename Sink>
+  size_t lexRange(std::string_view input,
+                  size_t begin,
+                  size_t end,
+                  Context& ctx,
+                  Sink& sink,
+                  size_t limit = std::numeric_limits<size_t>::max()) {
+    constexpr bool threaded = D == Dispatch::COMPUTED_GOTO;
+    static_assert(!threaded || JSON_LEXER_HAS_COMPUTED_GOTO, "编译器不支持 computed goto");
+#if JSON_LEXER_HAS_COMPUTED_GOTO
+    // 下标与 State 的取值一一对应
+    [[maybe_unused]] static void* const targets[] = {
+      &&TARGET_INIT,
+      &&TARGET_IN_STRING,
+      &&TARGET_IN_TRUE,
+      &&TARGET_IN_FALSE,
+      &&TARGET_IN_NULL,
+      &&TARGET_IN_ESCAPE,
+      &&TARGET_IN_UNICODE_ESCAPE,
+      &&TARGET_AFTER_HIGH_SURROGATE,
+      &&TARGET_BEFORE_LOW_SURROGATE,
+      &&TARGET_IN_LOW_SURROGATE,
+      &&TARGET_IN_UTF8_SEQUENCE,
+      &&TARGET_AFTER_NUMBER_INTEGER_SIGN,
+      &&TARGET_AFTER_NUMBER_LEADING_ZERO,
+      &&TARGET_IN_NUMBER_INTEGER,
+      &&TARGET_AFTER_NUMBER_POINT,
+      &&TARGET_IN_NUMBER_FRACTION_DIGIT,
+      &&TARGET_IN_NUMBER_EXPONENT,
+      &&TARGET_AFTER_NUMBER_EXPONENT_SIGN,
+      &&TARGET_IN_NUMBER_EXPONENT_DIGIT,
+      &&TARGET_INVALID,
+    };
+    static_assert(std::size(targets) == static_cast<size_t>(State::INVALID) + 1);
+#endif
+
+    auto state = ctx.state;
+    uint8_t keywordLength = ctx.keywordLength;
+    uint32_t unicodeValue = ctx.unicodeValue;
+    uint8_t unicodeDigits = ctx.unicodeDigits;
+    size_t i = begin, tokenStart = ctx.tokenStart;
+    uint32_t highSurrogate = ctx.highSurrogate;
+    bool hasEscapes = ctx.hasEscapes;
+    auto utf8 = ctx.utf8;
+    const bool validate = options.validateStrings;
+    char c;
+    while (i < end) {
+      c = input[i++];
+      switch (state) {
+        JSON_LEXER_CASE(INIT):
+          // 处于 INIT 时没有未完成的 token，可以直接停下，下次从当前字符继续
+          if (sink.size() >= limit) {
+            i--;
+            goto stop;
+          }
+          switch (util::charClass(c)) {
+            case util::CharClass::OBJECT_START:
+              sink.push(TokenType::OBJECT_START, i - 1, 1);
+              break;
+            case util::CharClass::OBJECT_END:
+              sink.push(TokenType::OBJECT_END, i - 1, 1);
+              break;
+            case util::CharClass::COLON:
+              sink.push(TokenType::COLON, i - 1, 1);
+              break;
+            case util::CharClass::COMMA:
+              sink.push(TokenType::COMMA, i - 1, 1);
+              break;
+            case util::CharClass::ARRAY_START:
+              sink.push(TokenType::ARRAY_START, i - 1, 1);
+              break;
+            case util::CharClass::ARRAY_END:
+              sink.push(TokenType::ARRAY_END, i - 1, 1);
+              break;
+            case util::CharClass::QUOTE:
+              state = State::IN_STRING;
+              tokenStart = i - 1;
+              break;
+            case util::CharClass::MINUS:
+              state = State::AFTER_NUMBER_INTEGER_SIGN;
+              tokenStart = i - 1;
+              break;
+            case util::CharClass::ZERO:
+              state = State::AFTER_NUMBER_LEADING_ZERO;
+              tokenStart = i - 1;
+              break;
+            case util::CharClass::DIGIT:
+              state = State::IN_NUMBER_INTEGER;
+              tokenStart = i - 1;
+              break;
+            // 剩余的输入放得下整个关键字时一次比较完；放不下或者不匹配时逐字节匹配，
+            // 由状态给出准确的出错位置
+            case util::CharClass::LETTER_T:
+              tokenStart = i - 1;
+              if (end - tokenStart >= 4
+                  && simd::load32(input.data() + tokenStart) == simd::word32("true")) {
+                sink.push(TokenType::BOOLEAN, tokenStart, 4, 1);
+                i += 3;
+              } else {
+                state = State::IN_TRUE;
+                keywordLength = 1;
+              }
+              break;
+            case util::CharClass::LETTER_F:
+              // 首字节已经确定是 f，只需比较后面 4 个字节
+              tokenStart = i - 1;
+              if (end - tokenStart >= 5 && simd::load32(input.data() + i) == simd::word32("alse")) {
+                sink.push(TokenType::BOOLEAN, tokenStart, 5, 0);
+                i += 4;
+              } else {
+                state = State::IN_FALSE;
+                keywordLength = 1;
+              }
+              break;
+            case util::CharClass::LETTER_N:
+              tokenStart = i - 1;
+              if (end - tokenStart >= 4
+                  && simd::load32(input.data() + tokenStart) == simd::word32("null")) {
+                sink.push(TokenType::NULL_VALUE, tokenStart, 4);
+                i += 3;
+              } else {
+                state = State::IN_NULL;
+                keywordLength = 1;
+              }
+              break;
+            case util::CharClass::WHITESPACE:
+              // 缩进往往是成段的空白，一次跳到下一个非空白字节
+              i = simd::skipWhitespace(input.data() + i, input.data() + end) - input.data();
+              break;
+            default:
+              ctx.error = {ErrorCode::UNKNOWN_CHARACTER, state, i - 1};
+              goto stop;
+          }
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(AFTER_NUMBER_INTEGER_SIGN):
+        JSON_LEXER_CASE(AFTER_NUMBER_LEADING_ZERO):
+        JSON_LEXER_CASE(IN_NUMBER_INTEGER):
+        JSON_LEXER_CASE(AFTER_NUMBER_POINT):
+        JSON_LEXER_CASE(IN_NUMBER_FRACTION_DIGIT):
+        JSON_LEXER_CASE(IN_NUMBER_EXPONENT):
+        JSON_LEXER_CASE(AFTER_NUMBER_EXPONENT_SIGN):
+        JSON_LEXER_CASE(IN_NUMBER_EXPONENT_DIGIT): {
+          auto next = numberTransition(state, c);
+          if (next == State::INIT) {
             state = State::INIT;
             i--;
-            tokens.push_back(std::make_unique<NumberToken>(buffer));
-            buffer.clear();
+            pushNumber(input, tokenStart, i - tokenStart, sink);
+          } else if (next == State::INVALID) {
+            ctx.error = {ErrorCode::INVALID_NUMBER, state, i - 1};
+            goto stop;
+          } else {
+            state = next;
+            // 整数和小数部分中成段的数字每次跳过 8 个，停在第一个非数字字节上
+            if (state == State::IN_NUMBER_INTEGER || state == State::IN_NUMBER_FRACTION_DIGIT) {
+              i = simd::skipDigits(input.data() + i, input.data() + end) - input.data();
+            }
           }
-          break;
-        case State::IN_STRING:
+          JSON_LEXER_NEXT();
+        }
+        JSON_LEXER_CASE(IN_STRING):
           if (c == '"') {
             state = State::INIT;
-            tokens.push_back(std::make_unique<StringToken>(buffer));
-            buffer.clear();
+            sink.pushString(tokenStart, i - tokenStart, hasEscapes);
+            hasEscapes = false;
           } else if (c == '\\') {
             state = State::IN_ESCAPE;
+            hasEscapes = true;
+          } else if (!validate) {
+            // 普通字符成段跳过，直接停在下一个需要处理的字节上
+            i = simd::findStringSpecial(input.data() + i, input.data() + end) - input.data();
+          } else if (static_cast<uint8_t>(c) < 0x20) {
+            ctx.error = {ErrorCode::CONTROL_CHARACTER, state, i - 1};
+            goto stop;
+          } else if (static_cast<uint8_t>(c) < 0x80) {
+            i = simd::findStringSpecialUtf8(input.data() + i, input.data() + end) - input.data();
           } else {
-            buffer += c;
+            // 多字节序列的首字节：序列完整合法时连同后面的内容一起跳过；
+            // 扫描停在它本身上说明它非法或者被 end 截断，逐字节检查以给出准确位置或跨 chunk 继续
+            auto lead = input.data() + i - 1;
+            auto next = simd::findStringSpecialUtf8(lead, input.data() + end);
+            if (next != lead) {
+              i = next - input.data();
+            } else {
+              utf8 = simd::utf8Lead(static_cast<uint8_t>(c));
+              if (utf8.continuations == 0) {
+                ctx.error = {ErrorCode::INVALID_UTF8, state, i - 1};
+                goto stop;
+              }
+              state = State::IN_UTF8_SEQUENCE;
+            }
           }
-          break;
-        case State::IN_TRUE:
-          buffer += c;
-          if (buffer == "tr" || buffer == "tru") {
-          } else if (buffer == "true") {
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_UTF8_SEQUENCE):
+          if (static_cast<uint8_t>(c) < utf8.lower || static_cast<uint8_t>(c) > utf8.upper) {
+            ctx.error = {ErrorCode::INVALID_UTF8, state, i - 1};
+            goto stop;
+          }
+          utf8 = {static_cast<uint8_t>(utf8.continuations - 1), 0x80, 0xBF};
+          if (utf8.continuations == 0) state = State::IN_STRING;
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_TRUE):
+          if (c != "true"[keywordLength]) {
+            ctx.error = {ErrorCode::UNKNOWN_CHARACTER, state, i - 1};
+            goto stop;
+          }
+          if (++keywordLength == 4) {
             state = State::INIT;
-            tokens.push_back(std::make_unique<BooleanToken>(true));
-            buffer.clear();
-          } else {
-            spdlog::info("未知的字符：{}", c);
-            exit(1);
+            sink.push(TokenType::BOOLEAN, tokenStart, i - tokenStart, 1);
           }
-          break;
-        case State::IN_FALSE:
-          buffer += c;
-          if (buffer == "fa" || buffer == "fal" || buffer == "fals") {
-          } else if (buffer == "false") {
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_FALSE):
+          if (c != "false"[keywordLength]) {
+            ctx.error = {ErrorCode::UNKNOWN_CHARACTER, state, i - 1};
+            goto stop;
+          }
+          if (++keywordLength == 5) {
             state = State::INIT;
-            tokens.push_back(std::make_unique<BooleanToken>(false));
-            buffer.clear();
-          } else {
-            spdlog::info("未知的字符：{}", c);
-            exit(1);
+            sink.push(TokenType::BOOLEAN, tokenStart, i - tokenStart, 0);
           }
-          break;
-        case State::IN_NULL:
-          buffer += c;
-          if (buffer == "nu" || buffer == "nul") {
-          } else if (buffer == "null") {
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_NULL):
+          if (c != "null"[keywordLength]) {
+            ctx.error = {ErrorCode::UNKNOWN_CHARACTER, state, i - 1};
+            goto stop;
+          }
+          if (++keywordLength == 4) {
             state = State::INIT;
-            tokens.push_back(std::make_unique<NullToken>());
-            buffer.clear();
-          } else {
-            spdlog::info("未知的字符：{}", c);
-            exit(1);
+            sink.push(TokenType::NULL_VALUE, tokenStart, i - tokenStart);
           }
-          break;
-        case State::IN_ESCAPE:
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_ESCAPE):
           switch (c) {
             case '"':
-              state = State::IN_STRING;
-              buffer += '"';
-              break;
             case '\\':
-              state = State::IN_STRING;
-              buffer += '\\';
-              break;
             case '/':
-              state = State::IN_STRING;
-              buffer += '/';
-              break;
             case 'b':
-              state = State::IN_STRING;
-              buffer += '\b';
-              break;
             case 'f':
-              state = State::IN_STRING;
-              buffer += '\f';
-              break;
             case 'n':
-              state = State::IN_STRING;
-              buffer += '\n';
-              break;
             case 'r':
-              state = State::IN_STRING;
-              buffer += '\r';
-              break;
             case 't':
               state = State::IN_STRING;
-              buffer += '\t';
               break;
-            case 'u':
-              state = State::IN_UNICODE_ESCAPE;
+            case 'u': {
+              // 4 位数字都在本段输入中时一次转换，紧跟的低位代理也一起检查；
+              // 数字不全或者有错时交给逐字节的状态，由它们跨段继续或者给出准确的出错位置
+              uint32_t codePoint = 0, low = 0;
+              if (end - i < 4 || !util::parseHex4(input.data() + i, codePoint)) {
+                state = State::IN_UNICODE_ESCAPE;
+                break;
+              }
+              if (util::isLowSurrogate(codePoint)) {
+                ctx.error = {ErrorCode::MISSING_HIGH_SURROGATE, State::IN_UNICODE_ESCAPE, i};
+                goto stop;
+              }
+              i += 4;
+              state = State::IN_STRING;
+              if (util::isHighSurrogate(codePoint)) {
+                if (end - i >= 6 && input[i] == '\\' && input[i + 1] == 'u'
+                    && util::parseHex4(input.data() + i + 2, low) && util::isLowSurrogate(low)) {
+                  i += 6;
+                } else {
+                  state = State::AFTER_HIGH_SURROGATE;
+                  highSurrogate = codePoint;
+                }
+              }
               break;
+            }
             default:
-              spdlog::info("未知的转义字符：{}", c);
-              exit(1);
+              ctx.error = {ErrorCode::INVALID_ESCAPE, state, i - 1};
+              goto stop;
           }
-          break;
-        case State::IN_UNICODE_ESCAPE:
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_UNICODE_ESCAPE):
           if (util::isHexDigit(c)) {
-            unicodeBuffer += c;
+            unicodeValue = unicodeValue << 4 | util::charToHex(c);
+            unicodeDigits++;
           } else {
-            spdlog::info("未知的 unicode 转义字符：{}", c);
-            exit(1);
+            ctx.error = {ErrorCode::INVALID_UNICODE_ESCAPE, state, i - 1};
+            goto stop;
           }
-          if (unicodeBuffer.size() == 4) {
-            auto codePoint = util::strToCodePoint(unicodeBuffer);
-            unicodeBuffer.clear();
+          if (unicodeDigits == 4) {
+            auto codePoint = unicodeValue;
+            unicodeValue = 0;
+            unicodeDigits = 0;
             if (util::isHighSurrogate(codePoint)) {
               state = State::AFTER_HIGH_SURROGATE;
               highSurrogate = codePoint;
             } else if (util::isLowSurrogate(codePoint)) {
-              spdlog::info("码点 {:#x} 缺少高位代理", codePoint);
-              exit(1);
+              ctx.error = {ErrorCode::MISSING_HIGH_SURROGATE, state, i - 4};
+              goto stop;
             } else {
               state = State::IN_STRING;
-              buffer += util::codePointToUtf8(codePoint);
             }
           }
-          break;
-        case State::AFTER_HIGH_SURROGATE:
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(AFTER_HIGH_SURROGATE):
           if (c == '\\') {
             state = State::BEFORE_LOW_SURROGATE;
           } else {
-            spdlog::info("高位代理后必须紧跟低位代理");
-            exit(1);
+            ctx.error = {ErrorCode::MISSING_LOW_SURROGATE, state, i - 1};
+            goto stop;
           }
-          break;
-        case State::BEFORE_LOW_SURROGATE:
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(BEFORE_LOW_SURROGATE):
           if (c == 'u') {
             state = State::IN_LOW_SURROGATE;
           } else {
-            spdlog::info("高位代理后必须紧跟低位代理");
-            exit(1);
+            ctx.error = {ErrorCode::MISSING_LOW_SURROGATE, state, i - 1};
+            goto stop;
           }
-          break;
-        case State::IN_LOW_SURROGATE:
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(IN_LOW_SURROGATE):
           if (util::isHexDigit(c)) {
-            unicodeBuffer += c;
+            unicodeValue = unicodeValue << 4 | util::charToHex(c);
+            unicodeDigits++;
           } else {
-            spdlog::info("未知的 unicode 转义字符：{}", c);
-            exit(1);
+            ctx.error = {ErrorCode::INVALID_UNICODE_ESCAPE, state, i - 1};
+            goto stop;
           }
-          if (unicodeBuffer.size() == 4) {
-            auto codePoint = util::strToCodePoint(unicodeBuffer);
-            unicodeBuffer.clear();
+          if (unicodeDigits == 4) {
+            auto codePoint = unicodeValue;
+            unicodeValue = 0;
+            unicodeDigits = 0;
             if (util::isLowSurrogate(codePoint)) {
               state = State::IN_STRING;
-              auto cp = util::mergeSurrogate(highSurrogate, codePoint);
-              buffer += util::codePointToUtf8(cp);
               highSurrogate = 0;
             } else {
-              spdlog::info("码点 {:#x} 不是低位代理", codePoint);
-              exit(1);
+              ctx.error = {ErrorCode::NOT_LOW_SURROGATE, state, i - 4};
+              goto stop;
             }
           }
-          break;
+          JSON_LEXER_NEXT();
+        JSON_LEXER_CASE(INVALID):
+          // 只出现在转移表中
+          JSON_LEXER_NEXT();
       }
     }
 
-    if (!unicodeBuffer.empty()) {
-      spdlog::info("不完整的 unicode 转义序列：{}", unicodeBuffer);
-      exit(1);
-    }
-    if (highSurrogate != 0) {
-      spdlog::info("未配对的 unicode 转义序列");
-      exit(1);
+  stop:
+    ctx.state = state;
+    ctx.tokenStart = tokenStart;
+    ctx.highSurrogate = highSurrogate;
+    ctx.hasEscapes = hasEscapes;
+    ctx.keywordLength = keywordLength;
+    ctx.utf8 = utf8;
+    ctx.unicodeValue = unicodeValue;
+    ctx.unicodeDigits = unicodeDigits;
+    return i;
+  }
+
+  static NumberKind parseNumber(const Options& options,
+                                std::string_view text,
+                                uint64_t& payload,
+                                int16_t& exponent) {
+    if (options.exactDecimals) return number::parseDecimal(text, payload, exponent);
+    return number::parse(text, payload);
+  }
+
+  template <typename Sink>
+  void pushNumber(std::string_view input, size_t start, size_t length, Sink& sink) {
+    if (!options.parseNumbers && !options.exactDecimals) {
+      sink.push(TokenType::NUMBER, start, length);
+      return;
     }
+    uint64_t payload = 0;
+    int16_t exponent = 0;
+    auto kind = parseNumber(options, input.substr(start, length), payload, exponent);
+    sink.pushNumber(start, length, kind, payload, exponent);
+  }
 
-    if (buffer.empty()) {
-      return tokens;
+  // 输入在 end 处结束：输出最后一个未完成的数值，其他未完成的 token 都是错误，记在 ctx.error 中
+  template <typename Sink>
+  void flush(std::string_view input, size_t end, Context& ctx, Sink& sink) {
+    auto state = ctx.state;
+    auto tokenStart = ctx.tokenStart;
+
+    if (ctx.unicodeDigits != 0) {
+      ctx.error = {ErrorCode::INCOMPLETE_UNICODE_ESCAPE, state, end - ctx.unicodeDigits};
+      return;
+    }
+    if (ctx.highSurrogate != 0) {
+      ctx.error = {ErrorCode::UNPAIRED_SURROGATE, state, tokenStart};
+      return;
     }
 
     switch (state) {
+      case State::INIT:
+        break;
       case State::AFTER_NUMBER_INTEGER_SIGN:
       case State::AFTER_NUMBER_POINT:
       case State::IN_NUMBER_EXPONENT:
       case State::AFTER_NUMBER_EXPONENT_SIGN:
-        spdlog::info("非法的数值：{}", buffer);
-        exit(1);
+        ctx.error = {ErrorCode::INCOMPLETE_NUMBER, state, tokenStart};
+        return;
       case State::AFTER_NUMBER_LEADING_ZERO:
       case State::IN_NUMBER_INTEGER:
-      case State::AFTER_NUMBER_INTEGER:
       case State::IN_NUMBER_FRACTION_DIGIT:
-      case State::AFTER_NUMBER_FRACTION:
       case State::IN_NUMBER_EXPONENT_DIGIT:
-        tokens.push_back(std::make_unique<NumberToken>(buffer));
-        buffer.clear();
+        pushNumber(input, tokenStart, end - tokenStart, sink);
         break;
       case State::IN_TRUE:
       case State::IN_FALSE:
       case State::IN_NULL:
-        spdlog::info("不全的关键字：{}", buffer);
-        exit(1);
+        ctx.error = {ErrorCode::INCOMPLETE_KEYWORD, state, tokenStart};
+        return;
       default:
-        spdlog::info("未闭合的字符串：{}", buffer);
-        exit(1);
+        ctx.error = {ErrorCode::UNCLOSED_STRING, state, tokenStart};
+        return;
     }
-
-    return tokens;
+    ctx.state = State::INIT;
   }
 };
+
+#undef JSON_LEXER_CASE
+#undef JSON_LEXER_NEXT
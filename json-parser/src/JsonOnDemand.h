@@ -0,0 +1,428 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "JsonDocument.h"
+#include "JsonLexer.h"
+#include "StructuralIndex.h"
+
+// 按需访问：parse 只建立结构索引，不分析 token、不建 DOM
+// 访问时沿索引前进，没有访问的值按括号配对整段跳过，字符串不解码、数值不转换，
+// 只有最终读取的值才交给词法分析器检查和转换
+// 因此没有访问到的部分即使有错也不会报告
+//
+//   JsonOnDemand doc;
+//   int64_t id;
+//   if (auto error = doc.parse(input)) { ... }
+//   if (auto error = doc.root()["user"]["id"].getInt64(id)) { ... error.message(input) ... }
+class JsonOnDemand {
+  public:
+    enum class ErrorCode : uint8_t {
+      NONE,
+      LEXER,               // 读取的值本身有误，见 Error::lexer
+      TOO_LARGE,           // 超出结构索引支持的 4 GiB
+      UNEXPECTED_TOKEN,    // 沿途经过的结构不合文法
+      UNEXPECTED_END,      // 输入在文档完整之前结束
+      NO_SUCH_KEY,
+      INDEX_OUT_OF_RANGE,
+      INCORRECT_TYPE,      // 值的类型与访问方式不符，整数超出目标类型的范围也算
+      NO_DOCUMENT,         // 默认构造的 Value，或者还没有 parse 就调用了 root()
+    };
+
+    struct Error {
+      ErrorCode code = ErrorCode::NONE;
+      size_t offset = 0;  // 出错处在输入中的偏移
+      JsonLexer::Error lexer;
+
+      explicit operator bool() const {
+        return code != ErrorCode::NONE;
+      }
+
+      const char* what() const {
+        switch (code) {
+          case ErrorCode::NONE:
+            return "";
+          case ErrorCode::LEXER:
+            return lexer.what();
+          case ErrorCode::TOO_LARGE:
+            return "输入过大";
+          case ErrorCode::UNEXPECTED_TOKEN:
+            return "不应出现在此处的 token";
+          case ErrorCode::UNEXPECTED_END:
+            return "文档不完整";
+          case ErrorCode::NO_SUCH_KEY:
+            return "对象中没有这个 key";
+          case ErrorCode::INDEX_OUT_OF_RANGE:
+            return "数组下标越界";
+          case ErrorCode::INCORRECT_TYPE:
+            return "值的类型不符";
+          case ErrorCode::NO_DOCUMENT:
+            return "没有可访问的文档";
+        }
+        return "";
+      }
+
+      std::string message(std::string_view input = {}) const {
+        if (code == ErrorCode::LEXER) return lexer.message(input);
+        if (code != ErrorCode::UNEXPECTED_TOKEN || offset >= input.size()) return what();
+        return fmt::format("{}：{}", what(), input[offset]);
+      }
+    };
+
+    // 指向结构索引中的一个位置；取值出错时错误沿着后续的访问传下去，最后由 get 系列函数返回
+    // 在同一个 JsonOnDemand 重新 parse 之前有效
+    class Value {
+      friend class JsonOnDemand;
+
+      private:
+        JsonOnDemand* doc = nullptr;
+        size_t k = 0;  // 值在结构索引中的下标
+        Error error;
+
+        Value(JsonOnDemand* doc, size_t k)
+            : doc(doc),
+              k(k) {}
+
+        Value fail(ErrorCode code, size_t offset) const {
+          Value value;
+          value.doc = doc;
+          value.error.code = code;
+          value.error.offset = offset;
+          return value;
+        }
+
+        // 读出 k 处的一个标量或字符串，没有出错时返回 nullptr 以外的 token
+        const TapeToken* lex(Error& result) const {
+          if (auto lexError = doc->lexAt(k)) {
+            result.code = ErrorCode::LEXER;
+            result.offset = lexError.offset;
+            result.lexer = lexError;
+            return nullptr;
+          }
+          auto token = &doc->tokens.tokens[0];
+          switch (token->type) {
+            case TokenType::STRING:
+            case TokenType::NUMBER:
+            case TokenType::BOOLEAN:
+            case TokenType::NULL_VALUE:
+              return token;
+            default:
+              // 值的位置上是分隔符或括号，例如 [1,] 的最后一个元素
+              result.code = ErrorCode::UNEXPECTED_TOKEN;
+              result.offset = token->offset;
+              return nullptr;
+          }
+        }
+
+        Error mismatch() const {
+          Error result;
+          result.code = ErrorCode::INCORRECT_TYPE;
+          result.offset = doc->offsetOf(k);
+          return result;
+        }
+
+      public:
+        // 不指向任何文档，所有访问都返回 ErrorCode::NO_DOCUMENT
+        Value() {
+          error.code = ErrorCode::NO_DOCUMENT;
+        }
+
+        // 按首字节判断，不检查值本身是否合法
+        JsonType type() const {
+          if (error) return JsonType::NULL_VALUE;
+          switch (doc->at(k)) {
+            case '{':
+              return JsonType::OBJECT;
+            case '[':
+              return JsonType::ARRAY;
+            case '"':
+              return JsonType::STRING;
+            case 't':
+            case 'f':
+              return JsonType::BOOLEAN;
+            case 'n':
+              return JsonType::NULL_VALUE;
+            default:
+              return JsonType::NUMBER;
+          }
+        }
+
+        const Error& status() const {
+          return error;
+        }
+
+        // 从对象开头逐个比较 key，不匹配的成员的值整段跳过；有重复的 key 时返回第一个
+        // key 不含转义时直接与输入中的原始内容比较，不做任何拷贝
+        Value operator[](std::string_view key) const {
+          if (error) return *this;
+          if (doc->at(k) != '{') return fail(ErrorCode::INCORRECT_TYPE, doc->offsetOf(k));
+          size_t n = doc->index.size();
+          size_t p = k + 1;
+          if (p < n && doc->at(p) == '}') return fail(ErrorCode::NO_SUCH_KEY, doc->offsetOf(k));
+          while (true) {
+            if (p + 2 >= n) return fail(ErrorCode::UNEXPECTED_END, doc->input.size());
+            if (doc->at(p) != '"') return fail(ErrorCode::UNEXPECTED_TOKEN, doc->offsetOf(p));
+            if (doc->at(p + 1) != ':') return fail(ErrorCode::UNEXPECTED_TOKEN, doc->offsetOf(p + 1));
+            if (doc->keyEquals(p, key)) return Value(doc, p + 2);
+            size_t next = doc->skip(p + 2);
+            if (next >= n) return fail(ErrorCode::UNEXPECTED_END, doc->input.size());
+            switch (doc->at(next)) {
+              case ',':
+                p = next + 1;
+                break;
+              case '}':
+                return fail(ErrorCode::NO_SUCH_KEY, doc->offsetOf(k));
+              default:
+                return fail(ErrorCode::UNEXPECTED_TOKEN, doc->offsetOf(next));
+            }
+          }
+        }
+
+        // 跳过前面的 i 个元素，每个元素整段跳过
+        Value operator[](size_t i) const {
+          if (error) return *this;
+          if (doc->at(k) != '[') return fail(ErrorCode::INCORRECT_TYPE, doc->offsetOf(k));
+          size_t n = doc->index.size();
+          size_t p = k + 1;
+          if (p >= n) return fail(ErrorCode::UNEXPECTED_END, doc->input.size());
+          if (doc->at(p) == ']') return fail(ErrorCode::INDEX_OUT_OF_RANGE, doc->offsetOf(k));
+          for (; i > 0; --i) {
+            size_t next = doc->skip(p);
+            if (next >= n) return fail(ErrorCode::UNEXPECTED_END, doc->input.size());
+            switch (doc->at(next)) {
+              case ',':
+                p = next + 1;
+                break;
+              case ']':
+                return fail(ErrorCode::INDEX_OUT_OF_RANGE, doc->offsetOf(k));
+              default:
+                return fail(ErrorCode::UNEXPECTED_TOKEN, doc->offsetOf(next));
+            }
+          }
+          if (p >= n) return fail(ErrorCode::UNEXPECTED_END, doc->input.size());
+          return Value(doc, p);
+        }
+
+        Value operator[](int i) const {
+          return (*this)[static_cast<size_t>(i)];
+        }
+
+        Error getInt64(int64_t& out) const {
+          if (error) return error;
+          if (type() != JsonType::NUMBER) return mismatch();
+          Error result;
+          auto token = lex(result);
+          if (token == nullptr) return result;
+          switch (TokenTape::numberKind(*token)) {
+            case NumberKind::INT64:
+              out = TokenTape::int64(*token);
+              return result;
+            default:
+              return mismatch();
+          }
+        }
+
+        Error getUint64(uint64_t& out) const {
+          if (error) return error;
+          if (type() != JsonType::NUMBER) return mismatch();
+          Error result;
+          auto token = lex(result);
+          if (token == nullptr) return result;
+          auto kind = TokenTape::numberKind(*token);
+          if (kind == NumberKind::UINT64 || (kind == NumberKind::INT64 && TokenTape::int64(*token) >= 0)) {
+            out = TokenTape::uint64(*token);
+            return result;
+          }
+          return mismatch();
+        }
+
+        Error getDouble(double& out) const {
+          if (error) return error;
+          if (type() != JsonType::NUMBER) return mismatch();
+          Error result;
+          auto token = lex(result);
+          if (token == nullptr) return result;
+          out = TokenTape::toDouble(*token);
+          return result;
+        }
+
+        // 不含转义时指向输入，否则指向 JsonOnDemand 内部的缓冲区，在下一次 getString 之前有效
+        Error getString(std::string_view& out) const {
+          if (error) return error;
+          if (type() != JsonType::STRING) return mismatch();
+          Error result;
+          auto token = lex(result);
+          if (token == nullptr) return result;
+          out = TokenTape::string(*token, doc->input, doc->scratch);
+          return result;
+        }
+
+        Error getBool(bool& out) const {
+          if (error) return error;
+          if (type() != JsonType::BOOLEAN) return mismatch();
+          Error result;
+          auto token = lex(result);
+          if (token == nullptr) return result;
+          out = token->payload != 0;
+          return result;
+        }
+
+        // 只向前的游标，逐个访问数组元素；遇到不合文法的结构时提前结束，需要区分时用 operator[]
+        class Iterator {
+          private:
+            JsonOnDemand* doc;
+            size_t k;  // 结束时是 NPOS
+
+          public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Value;
+
+            static constexpr size_t NPOS = ~size_t(0);
+
+            Iterator(JsonOnDemand* doc, size_t k)
+                : doc(doc),
+                  k(k) {}
+
+            Value operator*() const {
+              return Value(doc, k);
+            }
+
+            Iterator& operator++() {
+              size_t next = doc->skip(k);
+              k = next < doc->index.size() && doc->at(next) == ',' && next + 1 < doc->index.size()
+                      ? next + 1
+                      : NPOS;
+              return *this;
+            }
+
+            bool operator==(const Iterator& other) const {
+              return k == other.k;
+            }
+
+            bool operator!=(const Iterator& other) const {
+              return k != other.k;
+            }
+        };
+
+        // 不是数组或者数组为空时 begin 等于 end
+        Iterator begin() const {
+          bool empty = error || doc->at(k) != '[' || k + 1 >= doc->index.size() || doc->at(k + 1) == ']';
+          return Iterator(doc, empty ? Iterator::NPOS : k + 1);
+        }
+
+        Iterator end() const {
+          return Iterator(doc, Iterator::NPOS);
+        }
+    };
+
+    struct Options {
+      // parse 时顺带建立括号配对表：多花一遍对结构位置的扫描，之后每次跳过子树都是 O(1)，
+      // 同一份输入要查询多次时划算；括号不配对的输入在 parse 时就会报错
+      bool matchBrackets = false;
+    };
+
+  private:
+    Options options;
+    std::string_view input;
+    StructuralIndex index;
+    Error parseError{ErrorCode::NO_DOCUMENT};
+    JsonLexer lexer{JsonLexer::Options{true}};
+    // 最近一次读取的值，以及解码带转义字符串的缓冲区
+    TokenTape tokens;
+    std::string scratch;
+
+    char at(size_t k) const {
+      return input[index[k]];
+    }
+
+    size_t offsetOf(size_t k) const {
+      return k < index.size() ? index[k] : input.size();
+    }
+
+    // k 处的值之后的下一个结构位置：标量和字符串只占一个位置，
+    // 数组和对象有配对表时直接查表，否则只看括号的深度，其间的 key、值和分隔符都不检查
+    // 不用 simd::skipValue：结构索引已经排除了字符串里的括号，这里只访问结构位置，
+    // 而 skipValue 要重新扫描原始字节，返回的字节位置还得再二分查回索引下标
+    size_t skip(size_t k) const {
+      char c = at(k);
+      if (c != '{' && c != '[') return k + 1;
+      if (index.hasMatches()) return index.match(k) + 1;
+      size_t depth = 1;
+      size_t n = index.size();
+      for (size_t p = k + 1; p < n; ++p) {
+        switch (at(p)) {
+          case '{':
+          case '[':
+            ++depth;
+            break;
+          case '}':
+          case ']':
+            if (--depth == 0) return p + 1;
+            break;
+        }
+      }
+      return n;
+    }
+
+    // p 处的 key 是否等于 key，p + 1 处已经确认是冒号
+    bool keyEquals(size_t p, std::string_view key) {
+      size_t start = index[p];
+      size_t last = index[p + 1];
+      // 从冒号往回跳过空白，找到 key 的结束引号
+      while (last > start + 1 && util::isBlank(input[last - 1])) --last;
+      if (last <= start + 1 || input[last - 1] != '"') return false;
+      auto raw = input.substr(start + 1, last - start - 2);
+      if (std::memchr(raw.data(), '\\', raw.size()) == nullptr) return raw == key;
+      // 带转义的 key 要先经过检查，再边解码边比较，不占用 getString 的缓冲区
+      if (lexAt(p)) return false;
+      return util::unescapedEquals(raw, key);
+    }
+
+    JsonLexer::Error lexAt(size_t k) {
+      size_t end = k + 1 < index.size() ? index[k + 1] : input.size();
+      auto error = lexer.lexValue(input, index[k], end, tokens);
+      if (!error && tokens.size() != 1) {
+        // 索引中的一个位置只会有一个 token，这里只是防御
+        error = {JsonLexer::ErrorCode::UNKNOWN_CHARACTER, JsonLexer::State::INIT, index[k]};
+      }
+      return error;
+    }
+
+  public:
+    JsonOnDemand() = default;
+
+    explicit JsonOnDemand(Options options)
+        : options(options) {}
+
+    // 只建立结构索引（以及可选的括号配对表）；input 必须在之后的访问期间保持有效
+    // 可以对同一份输入反复调用 root() 查询，索引只建一次
+    Error parse(std::string_view json) {
+      input = json;
+      Error error;
+      size_t failure;
+      if (!index.build(input)) {
+        error.code = ErrorCode::TOO_LARGE;
+      } else if (index.size() == 0) {
+        error.code = ErrorCode::UNEXPECTED_END;
+        error.offset = input.size();
+      } else if (options.matchBrackets && !index.matchBrackets(input, failure)) {
+        error.code = failure < index.size() ? ErrorCode::UNEXPECTED_TOKEN : ErrorCode::UNEXPECTED_END;
+        error.offset = offsetOf(failure);
+      }
+      parseError = error;
+      return error;
+    }
+
+    // 文档的根值；parse 出错时访问它会得到同样的错误
+    Value root() {
+      Value value(this, 0);
+      if (parseError) value.error = parseError;
+      return value;
+    }
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonLexer.h"
+#include "StructuralIndex.h"
+
+// SAX 风格的解析：在词法分析器的 token 上检查文法，把事件直接交给调用方的处理器，
+// 不构造 Token 对象，也不先存下全部 token
+// 处理器的类型是模板参数，回调在编译期确定，可以被内联；不需要虚函数，也不经过 std::function
+//
+// 处理器需要提供以下成员函数，返回 false 时解析立即停止，结果是 ErrorCode::ABORTED，
+// 中止的原因由处理器自己记下，需要时填进 Error::reason：
+//   bool onObjectStart();
+//   bool onObjectEnd(size_t count);   // count 是成员个数
+//   bool onArrayStart();
+//   bool onArrayEnd(size_t count);    // count 是元素个数
+//   bool onKey(std::string_view key);
+//   bool onString(std::string_view value);
+//   bool onNumber(const TapeToken& token, std::string_view input);  // 用 TokenTape 的函数取值
+//   bool onBool(bool value);
+//   bool onNull();
+// key 和字符串已经解码，视图只在回调期间有效
+//
+//   struct Counter { ... };
+//   JsonParser parser;
+//   Counter counter;
+//   if (auto error = parser.parse(input, counter)) { ... error.message(input) ... }
+class JsonParser {
+  public:
+    enum class ErrorCode : uint8_t {
+      NONE,
+      LEXER,              // 见 Error::lexer
+      UNEXPECTED_TOKEN,   // token 出现在文法不允许的位置
+      UNEXPECTED_END,     // 输入在文档完整之前结束
+      EXTRA_TOKEN,        // 文档之后还有 token
+      ABORTED,            // 处理器的回调返回了 false，见 Error::reason
+    };
+
+    struct Error {
+      ErrorCode code = ErrorCode::NONE;
+      size_t offset = 0;  // 出错的 token 的起始偏移，输入提前结束时是输入的长度
+      JsonLexer::Error lexer;
+      const char* reason = nullptr;  // ABORTED 时由处理器给出的说明，没有时为 nullptr
+
+      explicit operator bool() const {
+        return code != ErrorCode::NONE;
+      }
+
+      const char* what() const {
+        switch (code) {
+          case ErrorCode::NONE:
+            return "";
+          case ErrorCode::LEXER:
+            return lexer.what();
+          case ErrorCode::UNEXPECTED_TOKEN:
+            return "不应出现在此处的 token";
+          case ErrorCode::UNEXPECTED_END:
+            return "文档不完整";
+          case ErrorCode::EXTRA_TOKEN:
+            return "文档之后还有多余的 token";
+          case ErrorCode::ABORTED:
+            return reason != nullptr ? reason : "解析被中止";
+        }
+        return "";
+      }
+
+      std::string message(std::string_view input = {}) const {
+        if (code == ErrorCode::LEXER) return lexer.message(input);
+        // 只有这两种错误的 offset 指向一个 token
+        bool atToken = code == ErrorCode::UNEXPECTED_TOKEN || code == ErrorCode::EXTRA_TOKEN;
+        if (!atToken || offset >= input.size()) return what();
+        return fmt::format("{}：{}", what(), input[offset]);
+      }
+    };
+
+  private:
+    // 还没有闭合的数组或对象
+    struct Frame {
+      uint64_t count;  // 已经完成的成员个数
+      bool object;
+    };
+
+    // 下一个 token 应当是什么
+    enum class Expect : uint8_t {
+      VALUE,
+      FIRST_ELEMENT,  // 值或 ]
+      KEY,
+      FIRST_KEY,      // key 或 }
+      COLON,
+      AFTER_VALUE,    // 逗号或所在容器的结束符
+    };
+
+    JsonLexer lexer;
+    // 以下只在 parse 期间使用，跨 parse 复用已经扩好的容量
+    std::vector<Frame> stack;
+    std::string scratch;
+
+    template <typename Handler>
+    Error run(JsonLexer::Cursor& source, std::string_view input, Handler& handler) {
+      stack.clear();
+      Error error;
+      auto fail = [&](ErrorCode code, size_t offset) {
+        error.code = code;
+        error.offset = offset;
+        return error;
+      };
+
+      auto expect = Expect::VALUE;
+      bool complete = false;  // 根已经完成
+      for (const TapeToken& token : source) {
+        if (complete) return fail(ErrorCode::EXTRA_TOKEN, token.offset);
+        auto type = token.type;
+        bool accepted = true;
+        switch (expect) {
+          case Expect::FIRST_KEY:
+            if (type == TokenType::OBJECT_END) {
+              accepted = handler.onObjectEnd(0);
+              stack.pop_back();
+              expect = Expect::AFTER_VALUE;
+              break;
+            }
+            [[fallthrough]];
+          case Expect::KEY:
+            if (type != TokenType::STRING) return fail(ErrorCode::UNEXPECTED_TOKEN, token.offset);
+            accepted = handler.onKey(TokenTape::string(token, input, scratch));
+            expect = Expect::COLON;
+            break;
+          case Expect::COLON:
+            if (type != TokenType::COLON) return fail(ErrorCode::UNEXPECTED_TOKEN, token.offset);
+            expect = Expect::VALUE;
+            break;
+          case Expect::AFTER_VALUE: {
+            auto& frame = stack.back();
+            if (type == TokenType::COMMA) {
+              expect = frame.object ? Expect::KEY : Expect::VALUE;
+            } else if (frame.object && type == TokenType::OBJECT_END) {
+              accepted = handler.onObjectEnd(frame.count);
+              stack.pop_back();
+            } else if (!frame.object && type == TokenType::ARRAY_END) {
+              accepted = handler.onArrayEnd(frame.count);
+              stack.pop_back();
+            } else {
+              return fail(ErrorCode::UNEXPECTED_TOKEN, token.offset);
+            }
+            break;
+          }
+          case Expect::FIRST_ELEMENT:
+            if (type == TokenType::ARRAY_END) {
+              accepted = handler.onArrayEnd(0);
+              stack.pop_back();
+              expect = Expect::AFTER_VALUE;
+              break;
+            }
+            [[fallthrough]];
+          case Expect::VALUE:
+            // 容器的值在闭合时才算完成，标量的值在这里完成
+            switch (type) {
+              case TokenType::OBJECT_START:
+                accepted = handler.onObjectStart();
+                stack.push_back({0, true});
+                expect = Expect::FIRST_KEY;
+                break;
+              case TokenType::ARRAY_START:
+                accepted = handler.onArrayStart();
+                stack.push_back({0, false});
+                expect = Expect::FIRST_ELEMENT;
+                break;
+              case TokenType::STRING:
+                accepted = handler.onString(TokenTape::string(token, input, scratch));
+                expect = Expect::AFTER_VALUE;
+                break;
+              case TokenType::NUMBER:
+                accepted = handler.onNumber(token, input);
+                expect = Expect::AFTER_VALUE;
+                break;
+              case TokenType::BOOLEAN:
+                accepted = handler.onBool(token.payload != 0);
+                expect = Expect::AFTER_VALUE;
+                break;
+              case TokenType::NULL_VALUE:
+                accepted = handler.onNull();
+                expect = Expect::AFTER_VALUE;
+                break;
+              default:
+                return fail(ErrorCode::UNEXPECTED_TOKEN, token.offset);
+            }
+            break;
+        }
+        if (!accepted) return fail(ErrorCode::ABORTED, token.offset);
+        // 刚完成了一个值：没有未闭合的容器时就是根，否则计入栈顶容器的成员个数
+        if (expect == Expect::AFTER_VALUE) {
+          if (stack.empty()) {
+            complete = true;
+          } else {
+            stack.back().count++;
+          }
+        }
+      }
+      if (!complete) return fail(ErrorCode::UNEXPECTED_END, input.size());
+      return error;
+    }
+
+    // 游标按批分析，词法错误可能在 run 停下的位置之后；只有 run 因为 token 用完而停下，
+    // 或者词法错误的位置更早时，才报告词法错误
+    template <typename Handler>
+    Error drive(JsonLexer::Cursor cursor, std::string_view input, Handler& handler) {
+      auto error = run(cursor, input, handler);
+      const auto& lexerError = cursor.error();
+      bool exhausted = !error || error.code == ErrorCode::UNEXPECTED_END;
+      if (lexerError && (exhausted || lexerError.offset < error.offset)) {
+        error = Error();
+        error.code = ErrorCode::LEXER;
+        error.offset = lexerError.offset;
+        error.lexer = lexerError;
+      }
+      return error;
+    }
+
+  public:
+    explicit JsonParser(JsonLexer::Options options = {})
+        : lexer(options) {}
+
+    // 边分析边回调，token 按批产生，不需要先存下全部 token
+    // 出错时处理器已经收到了出错之前的事件
+    template <typename Handler>
+    Error parse(std::string_view input, Handler& handler) {
+      return drive(lexer.cursor(input), input, handler);
+    }
+
+    // 在结构索引的第二阶段输出上回调，index 必须由同一个 input 构建
+    // 同样按批产生 token，除索引本身外不需要与输入大小成比例的内存
+    template <typename Handler>
+    Error parse(std::string_view input, const StructuralIndex& index, Handler& handler) {
+      return drive(lexer.cursor(input, index), input, handler);
+    }
+};
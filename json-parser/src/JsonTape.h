@@ -0,0 +1,350 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonDocument.h"
+#include "JsonLexer.h"
+#include "JsonParser.h"
+#include "StructuralIndex.h"
+
+// 扁平的 DOM：整个文档按先序写成一条 uint64_t 的 tape，字符串另放在一块缓冲区里
+// 每一项的高 8 位是类型字符，低 56 位是载荷：
+//   '{' '['  匹配的结束项之后的下标
+//   '}' ']'  成员个数
+//   '"'      字符串在 strings 中的偏移，那里先是 8 字节的长度，再是解码后的内容和一个 '\0'
+// 下标和偏移都不能超过 2^56，超出时 parse 返回 ErrorCode::ABORTED
+//   'l' 'u' 'd'  int64、uint64、double，下一项是它的原始位
+//   't' 'f' 'n'  没有载荷
+// 跳过一个子树只需读开始项里的下标，遍历就是顺序扫描
+//
+//   JsonTape tape;
+//   if (auto error = tape.parse(input)) { ... }
+//   auto id = tape.root().find("user").find("id").int64();
+class JsonTape {
+  friend class JsonParser;
+
+  public:
+    using Error = JsonParser::Error;
+    using ErrorCode = JsonParser::ErrorCode;
+
+    static constexpr uint64_t PAYLOAD_MASK = (1ULL << 56) - 1;
+
+    std::vector<uint64_t> tape;
+    std::string strings;
+
+    static char typeOf(uint64_t word) {
+      return static_cast<char>(word >> 56);
+    }
+
+    static uint64_t payloadOf(uint64_t word) {
+      return word & PAYLOAD_MASK;
+    }
+
+    // tape 和字符串缓冲区的只读视图，可以指向 JsonTape 自己的内存，也可以指向映射进来的文件
+    struct View {
+      const uint64_t* tape = nullptr;
+      size_t size = 0;  // tape 的项数
+      const char* strings = nullptr;
+    };
+
+    // tape 中一个值的位置，只在视图指向的内存不变时有效；index 越界时表示“不存在”，类型为 null
+    class Value {
+      private:
+        View view;
+        size_t index = 0;
+
+        uint64_t word() const {
+          return view.tape[index];
+        }
+
+      public:
+        Value() = default;
+
+        Value(const View& view, size_t index)
+            : view(view),
+              index(index) {}
+
+        bool exists() const {
+          return index < view.size;
+        }
+
+        size_t position() const {
+          return index;
+        }
+
+        JsonType type() const {
+          if (!exists()) return JsonType::NULL_VALUE;
+          switch (typeOf(word())) {
+            case 't':
+            case 'f':
+              return JsonType::BOOLEAN;
+            case 'l':
+            case 'u':
+            case 'd':
+              return JsonType::NUMBER;
+            case '"':
+              return JsonType::STRING;
+            case '[':
+              return JsonType::ARRAY;
+            case '{':
+              return JsonType::OBJECT;
+            default:
+              return JsonType::NULL_VALUE;
+          }
+        }
+
+        // 同层的下一个值：容器直接跳到匹配的结束项之后，数值占两项，其余占一项
+        size_t after() const {
+          auto w = word();
+          switch (typeOf(w)) {
+            case '[':
+            case '{':
+              return payloadOf(w);
+            case 'l':
+            case 'u':
+            case 'd':
+              return index + 2;
+            default:
+              return index + 1;
+          }
+        }
+
+        // 以下访问函数由调用方确保类型正确
+
+        bool boolean() const {
+          return typeOf(word()) == 't';
+        }
+
+        NumberKind numberKind() const {
+          switch (typeOf(word())) {
+            case 'l':
+              return NumberKind::INT64;
+            case 'u':
+              return NumberKind::UINT64;
+            default:
+              return NumberKind::DOUBLE;
+          }
+        }
+
+        int64_t int64() const {
+          return static_cast<int64_t>(view.tape[index + 1]);
+        }
+
+        uint64_t uint64() const {
+          return view.tape[index + 1];
+        }
+
+        double toDouble() const {
+          return number::toDouble(numberKind(), view.tape[index + 1]);
+        }
+
+        std::string_view string() const {
+          auto offset = payloadOf(word());
+          uint64_t length;
+          std::memcpy(&length, view.strings + offset, sizeof(length));
+          return {view.strings + offset + sizeof(length), length};
+        }
+
+        // 数组的元素个数或对象的成员个数，记在结束项里
+        size_t size() const {
+          return payloadOf(view.tape[after() - 1]);
+        }
+
+        // 按顺序跳过前面的元素，O(k) 次跳转，不访问被跳过的子树
+        // 这两个函数在不存在的值上返回不存在的值，可以连着写
+        Value operator[](size_t k) const {
+          if (type() != JsonType::ARRAY) return Value();
+          size_t end = after() - 1;
+          size_t position = index + 1;
+          for (; k > 0 && position < end; --k) position = Value(view, position).after();
+          return position < end ? Value(view, position) : Value();
+        }
+
+        // 没有时返回不存在的值
+        Value find(std::string_view key) const {
+          if (type() != JsonType::OBJECT) return Value();
+          size_t end = after() - 1;
+          for (size_t position = index + 1; position < end;) {
+            Value value(view, position + 1);
+            if (Value(view, position).string() == key) return value;
+            position = value.after();
+          }
+          return Value();
+        }
+
+        // 按顺序访问数组元素或对象成员（key 与 value 交替出现）
+        class Iterator {
+          private:
+            View view;
+            size_t index;
+
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Value;
+
+            Iterator(const View& view, size_t index)
+                : view(view),
+                  index(index) {}
+
+            Value operator*() const {
+              return Value(view, index);
+            }
+
+            Iterator& operator++() {
+              index = Value(view, index).after();
+              return *this;
+            }
+
+            bool operator==(const Iterator& other) const {
+              return index == other.index;
+            }
+
+            bool operator!=(const Iterator& other) const {
+              return index != other.index;
+            }
+        };
+
+        Iterator begin() const {
+          return Iterator(view, index + 1);
+        }
+
+        Iterator end() const {
+          return Iterator(view, after() - 1);
+        }
+    };
+
+  private:
+    JsonParser parser{JsonLexer::Options{true}};
+    // 各层未闭合容器的开始项在 tape 中的下标，只在 parse 期间使用
+    std::vector<size_t> stack;
+    // 回调返回 false 的原因
+    const char* abortReason = nullptr;
+
+    void push(char type, uint64_t payload) {
+      tape.push_back(static_cast<uint64_t>(static_cast<uint8_t>(type)) << 56 | payload);
+    }
+
+    void open(bool object) {
+      stack.push_back(tape.size());
+      push(object ? '{' : '[', 0);
+    }
+
+    // 结束项记下成员个数，开始项补上结束项之后的下标
+    bool close(bool object, uint64_t count) {
+      auto start = stack.back();
+      stack.pop_back();
+      push(object ? '}' : ']', count);
+      if (tape.size() > PAYLOAD_MASK) {
+        abortReason = "tape 超过 2^56 项";
+        return false;
+      }
+      tape[start] |= tape.size();
+      return true;
+    }
+
+    // JsonParser 的回调，key 和字符串值在 tape 上的形式相同
+
+    bool onObjectStart() {
+      open(true);
+      return true;
+    }
+
+    bool onArrayStart() {
+      open(false);
+      return true;
+    }
+
+    bool onObjectEnd(size_t count) {
+      return close(true, count);
+    }
+
+    bool onArrayEnd(size_t count) {
+      return close(false, count);
+    }
+
+    bool onKey(std::string_view key) {
+      return onString(key);
+    }
+
+    bool onString(std::string_view text) {
+      auto offset = strings.size();
+      if (offset > PAYLOAD_MASK) {
+        abortReason = "字符串缓冲区超过 2^56 字节";
+        return false;
+      }
+      push('"', offset);
+      // 一次扩容，长度、内容和结尾的 '\0' 直接写进去
+      uint64_t length = text.size();
+      strings.resize(offset + sizeof(length) + text.size() + 1);
+      auto out = strings.data() + offset;
+      std::memcpy(out, &length, sizeof(length));
+      std::memcpy(out + sizeof(length), text.data(), text.size());
+      out[sizeof(length) + text.size()] = '\0';
+      return true;
+    }
+
+    bool onNumber(const TapeToken& token, std::string_view) {
+      switch (TokenTape::numberKind(token)) {
+        case NumberKind::INT64:
+          push('l', 0);
+          break;
+        case NumberKind::UINT64:
+          push('u', 0);
+          break;
+        default:
+          // BIG 的 payload 已经是最接近的 double
+          push('d', 0);
+      }
+      tape.push_back(token.payload);
+      return true;
+    }
+
+    bool onBool(bool value) {
+      push(value ? 't' : 'f', 0);
+      return true;
+    }
+
+    bool onNull() {
+      push('n', 0);
+      return true;
+    }
+
+  public:
+    void clear() {
+      tape.clear();
+      strings.clear();
+      stack.clear();
+      abortReason = nullptr;
+    }
+
+    // 直接在词法分析器的输出上建立，token 按批产生，不需要先存下全部 token
+    // 出错时 tape 为空；超出上面所说的范围时是 ErrorCode::ABORTED，原因见 Error::reason
+    Error parse(std::string_view input) {
+      clear();
+      auto error = parser.parse(input, *this);
+      if (error.code == ErrorCode::ABORTED) error.reason = abortReason;
+      if (error) clear();
+      return error;
+    }
+
+    // 在结构索引的第二阶段输出上建立，index 必须由同一个 input 构建
+    Error parse(std::string_view input, const StructuralIndex& index) {
+      clear();
+      auto error = parser.parse(input, index, *this);
+      if (error.code == ErrorCode::ABORTED) error.reason = abortReason;
+      if (error) clear();
+      return error;
+    }
+
+    // 出错或者没有 parse 过时不存在
+    Value root() const {
+      return Value(View{tape.data(), tape.size(), strings.data()}, 0);
+    }
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define JSON_HAS_MMAP 1
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #define JSON_HAS_MMAP 0
+#endif
+
+// 把整个文件只读映射到内存，词法分析直接在映射的字节上进行，不需要先读进 std::string
+class MappedFile {
+  private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+      close();
+    }
+
+    // 只有普通文件才能映射；管道、终端、不支持 mmap 的平台都返回 false，调用方应改为按块读取
+    // hugePages 为 true 时提示内核用大页映射，内核不支持时忽略
+    bool open(const char* path, bool hugePages = false) {
+      close();
+#if JSON_HAS_MMAP
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0) return false;
+
+      struct stat st;
+      if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+      }
+      if (st.st_size == 0) {
+        // 长度为 0 的映射是非法的，空文件直接当作空输入
+        ::close(fd);
+        return true;
+      }
+
+      void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      // 映射建立后文件描述符就不再需要了
+      ::close(fd);
+      if (addr == MAP_FAILED) return false;
+
+      data = static_cast<const char*>(addr);
+      size = static_cast<size_t>(st.st_size);
+      // 词法分析从头到尾顺序读一遍，让内核加大预读并尽早回收读过的页
+      madvise(addr, size, MADV_SEQUENTIAL);
+  #if defined(MADV_HUGEPAGE)
+      if (hugePages) madvise(addr, size, MADV_HUGEPAGE);
+  #else
+      (void)hugePages;
+  #endif
+      return true;
+#else
+      (void)path;
+      (void)hugePages;
+      return false;
+#endif
+    }
+
+    void close() {
+#if JSON_HAS_MMAP
+      if (data != nullptr) munmap(const_cast<char*>(data), size);
+#endif
+      data = nullptr;
+      size = 0;
+    }
+
+    // 映射时按顺序读取来提示内核；之后要按需随机访问（例如查询持久化的 tape）时改为不预读
+    void adviseRandom() {
+#if JSON_HAS_MMAP
+      if (data != nullptr) madvise(const_cast<char*>(data), size, MADV_RANDOM);
+#endif
+    }
+
+    std::string_view view() const {
+      return {data, size};
+    }
+};
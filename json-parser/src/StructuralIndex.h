@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "simd.h"
+
+// 第一阶段：按 64 字节 block 向量化地找出所有结构位置
+// 结构位置包括字符串外的 {}[]:,、字符串的起始引号以及数值/关键字的首字节，
+// 第二阶段只需要访问这些位置，不再逐字节走状态机
+class StructuralIndex {
+  private:
+  // 跨 block 传递的状态
+  struct Carry {
+    uint64_t prevEscaped = 0;   // 上一个 block 以未配对的反斜杠结尾，本 block 首字节被转义
+    uint64_t prevInString = 0;  // 上一个 block 结束时仍在字符串内则为全 1
+    uint64_t prevScalar = 0;    // 上一个 block 的末字节是非引号的标量字符
+
+    // 去掉被转义的引号
+    uint64_t unescapedQuotes(const simd::BlockMasks& masks) {
+      return masks.quote & ~simd::escapedBytes(masks.backslash, prevEscaped);
+    }
+
+    uint64_t structurals(const simd::BlockMasks& masks, uint64_t quote, uint64_t inString) {
+      prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+      uint64_t scalar = ~(masks.op | masks.whitespace);
+      uint64_t nonQuoteScalar = scalar & ~quote;
+      uint64_t followsNonQuoteScalar = (nonQuoteScalar << 1) | prevScalar;
+      prevScalar = nonQuoteScalar >> 63;
+      uint64_t scalarStart = scalar & ~followsNonQuoteScalar;
+      // 字符串内部和结束引号：inString 为 1 的非引号字节，以及 inString 为 0 的引号
+      uint64_t stringTail = inString ^ quote;
+      return (masks.op | scalarStart) & ~stringTail;
+    }
+  };
+
+  std::unique_ptr<uint32_t[]> positions;
+  size_t count = 0;
+  size_t capacity = 0;
+
+  // 可选的括号配对表，与 positions 一一对应：{ [ 处是配对的 } ] 在索引中的下标，其余位置不用
+  std::unique_ptr<uint32_t[]> matches;
+  size_t matchCapacity = 0;
+  bool matched = false;
+  std::vector<uint32_t> openers;  // 建表时未闭合的括号，跨 build 复用
+
+  static void flatten(uint64_t bits, size_t base, uint32_t* out, size_t& count) {
+    while (bits) {
+      out[count++] = static_cast<uint32_t>(base + simd::trailingZeros(bits));
+      bits &= bits - 1;
+    }
+  }
+
+  // len 必须是 64 的倍数
+  static void indexScalar(const uint8_t* input,
+                          size_t len,
+                          size_t base,
+                          Carry& carry,
+                          uint32_t* out,
+                          size_t& count) {
+    for (size_t k = 0; k < len; k += 64) {
+      auto masks = simd::classifyScalar(input + k);
+      auto quote = carry.unescapedQuotes(masks);
+      auto inString = simd::prefixXorScalar(quote) ^ carry.prevInString;
+      flatten(carry.structurals(masks, quote, inString), base + k, out, count);
+    }
+  }
+
+#if JSON_SIMD_X86
+  JSON_TARGET("sse4.2,pclmul") static void indexSse42(const uint8_t* input,
+                                                      size_t len,
+                                                      size_t base,
+                                                      Carry& carry,
+                                                      uint32_t* out,
+                                                      size_t& count) {
+    for (size_t k = 0; k < len; k += 64) {
+      auto masks = simd::classifySse42(input + k);
+      auto quote = carry.unescapedQuotes(masks);
+      auto inString = simd::prefixXorClmul(quote) ^ carry.prevInString;
+      flatten(carry.structurals(masks, quote, inString), base + k, out, count);
+    }
+  }
+
+  JSON_TARGET("avx2,pclmul") static void indexAvx2(const uint8_t* input,
+                                                   size_t len,
+                                                   size_t base,
+                                                   Carry& carry,
+                                                   uint32_t* out,
+                                                   size_t& count) {
+    for (size_t k = 0; k < len; k += 64) {
+      auto masks = simd::classifyAvx2(input + k);
+      auto quote = carry.unescapedQuotes(masks);
+      auto inString = simd::prefixXorClmul(quote) ^ carry.prevInString;
+      flatten(carry.structurals(masks, quote, inString), base + k, out, count);
+    }
+  }
+#endif
+
+  static void index(simd::Kernel kernel,
+                    const uint8_t* input,
+                    size_t len,
+                    size_t base,
+                    Carry& carry,
+                    uint32_t* out,
+                    size_t& count) {
+    switch (kernel) {
+#if JSON_SIMD_X86
+      case simd::Kernel::AVX2:
+        indexAvx2(input, len, base, carry, out, count);
+        return;
+      case simd::Kernel::SSE42:
+        indexSse42(input, len, base, carry, out, count);
+        return;
+#endif
+      default:
+        indexScalar(input, len, base, carry, out, count);
+    }
+  }
+
+  public:
+  // 同一个对象可以反复 build，已分配的空间会被复用
+  // 结构索引最多支持 4 GiB 的输入，输入过大时返回 false，索引为空
+  bool build(std::string_view input, simd::Kernel kernel = simd::bestKernel()) {
+    count = 0;
+    matched = false;
+    if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+
+    // 结构位置的数量不会超过输入的字节数
+    if (capacity < input.size()) {
+      capacity = input.size();
+      positions.reset(new uint32_t[capacity]);
+    }
+
+    Carry carry;
+    auto data = reinterpret_cast<const uint8_t*>(input.data());
+    size_t full = input.size() / 64 * 64;
+    index(kernel, data, full, 0, carry, positions.get(), count);
+
+    // 最后不满 64 字节的部分用空白补齐，空白不会产生结构位置
+    if (full < input.size()) {
+      uint8_t tail[64];
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, data + full, input.size() - full);
+      index(kernel, tail, sizeof(tail), full, carry, positions.get(), count);
+    }
+    return true;
+  }
+
+  // 在 build 之后为所有括号建立配对表，input 必须与 build 时相同；只扫描一遍结构位置，
+  // 之后跳过任意子树都只需查一次表，多次查询同一份输入时不必每次重新数括号
+  // 括号不配对时返回 false，没有配对表；failure 是多余或类型不符的右括号在索引中的下标，
+  // 输入结束时仍有未闭合的括号则是 size()
+  bool matchBrackets(std::string_view input, size_t& failure) {
+    matched = false;
+    if (matchCapacity < count) {
+      matchCapacity = capacity;
+      matches.reset(new uint32_t[matchCapacity]);
+    }
+    openers.clear();
+    for (size_t k = 0; k < count; ++k) {
+      char c = input[positions[k]];
+      switch (c) {
+        case '{':
+        case '[':
+          openers.push_back(static_cast<uint32_t>(k));
+          break;
+        case '}':
+        case ']':
+          // '[' 与 ']'、'{' 与 '}' 都相差 2
+          if (openers.empty() || input[positions[openers.back()]] != c - 2) {
+            failure = k;
+            return false;
+          }
+          matches[openers.back()] = static_cast<uint32_t>(k);
+          openers.pop_back();
+          break;
+      }
+    }
+    if (!openers.empty()) {
+      failure = count;
+      return false;
+    }
+    matched = true;
+    return true;
+  }
+
+  bool hasMatches() const {
+    return matched;
+  }
+
+  // 由调用方确保已经成功 matchBrackets，且第 k 个结构位置是 { 或 [
+  uint32_t match(size_t k) const {
+    return matches[k];
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  uint32_t operator[](size_t k) const {
+    return positions[k];
+  }
+
+  const uint32_t* begin() const {
+    return positions.get();
+  }
+
+  const uint32_t* end() const {
+    return positions.get() + count;
+  }
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "JsonTape.h"
+#include "MappedFile.h"
+
+// JsonTape 的持久化格式：保存一次之后，启动时把文件映射进来就能查询，不需要重新分析 JSON
+// 布局，所有整数都是写入机器的字节序：
+//   Header   64 字节
+//   tape     tapeWords 个 uint64_t，紧跟在文件头之后，映射的起始地址按页对齐，所以 8 字节对齐
+//   strings  stringBytes 字节，与 JsonTape::strings 相同
+// 文件头有自己的校验和，打开时总会检查；tape 和字符串的校验和要读一遍整个文件，可以不检查
+//
+//   TapeFile::save(tape, "data.tape");
+//   TapeFile file;
+//   if (auto error = file.open("data.tape")) { ... error.what() ... }
+//   auto id = file.root().find("user").find("id").int64();
+class TapeFile {
+  public:
+    static constexpr char MAGIC[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+    // tape 的编码方式（见 JsonTape）有变化时加一，旧文件需要重新生成
+    // 2：容器的结束下标占满 56 位，成员个数移到结束项，字符串长度改为 8 字节
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+    // 在字节序相反的机器上读出来的 ENDIAN_MARK
+    static constexpr uint32_t SWAPPED_MARK = 0x04030201;
+
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      uint32_t byteOrder;  // 写入时是 ENDIAN_MARK，读出来不相等说明字节序不同
+      uint64_t tapeWords;
+      uint64_t stringBytes;
+      uint64_t tapeChecksum;
+      uint64_t stringsChecksum;
+      uint64_t headerChecksum;  // 以上各字段的校验和
+      uint64_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 64);
+
+    enum class ErrorCode : uint8_t {
+      NONE,
+      IO,                   // 无法打开、映射或写入文件
+      BAD_MAGIC,            // 不是 tape 文件
+      UNSUPPORTED_VERSION,
+      BYTE_ORDER_MISMATCH,  // 在字节序不同的机器上写入
+      BAD_HEADER,           // 文件头校验失败
+      TRUNCATED,            // 文件长度与文件头不符
+      CHECKSUM_MISMATCH,    // tape 或字符串的内容已损坏
+    };
+
+    struct Error {
+      ErrorCode code = ErrorCode::NONE;
+
+      explicit operator bool() const {
+        return code != ErrorCode::NONE;
+      }
+
+      const char* what() const {
+        switch (code) {
+          case ErrorCode::NONE:
+            return "";
+          case ErrorCode::IO:
+            return "无法读写文件";
+          case ErrorCode::BAD_MAGIC:
+            return "不是 tape 文件";
+          case ErrorCode::UNSUPPORTED_VERSION:
+            return "不支持的 tape 文件版本";
+          case ErrorCode::BYTE_ORDER_MISMATCH:
+            return "tape 文件的字节序与本机不同";
+          case ErrorCode::BAD_HEADER:
+            return "tape 文件头已损坏";
+          case ErrorCode::TRUNCATED:
+            return "tape 文件不完整";
+          case ErrorCode::CHECKSUM_MISMATCH:
+            return "tape 文件内容已损坏";
+        }
+        return "";
+      }
+    };
+
+    // 按 8 字节一组、4 路并行的乘法-旋转混合（XXH64 风格的轮函数），只用于发现损坏，不防篡改
+    // 4 路之间没有依赖，速度接近内存带宽
+    static uint64_t checksum(const void* data, size_t size) {
+      constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+      constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+      auto round = [](uint64_t acc, uint64_t word) {
+        acc += word * PRIME2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * PRIME1;
+      };
+
+      auto p = static_cast<const char*>(data);
+      uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+      size_t k = 0;
+      for (; k + 32 <= size; k += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+          uint64_t word;
+          std::memcpy(&word, p + k + lane * 8, sizeof(word));
+          lanes[lane] = round(lanes[lane], word);
+        }
+      }
+      uint64_t hash = size;
+      for (auto lane : lanes) hash = round(hash ^ round(0, lane), PRIME1);
+      for (; k < size; ++k) hash = round(hash, static_cast<uint8_t>(p[k]));
+      hash ^= hash >> 33;
+      hash *= PRIME2;
+      hash ^= hash >> 29;
+      return hash;
+    }
+
+  private:
+    MappedFile file;
+    JsonTape::View view;
+
+    static uint64_t headerChecksum(const Header& header) {
+      return checksum(&header, offsetof(Header, headerChecksum));
+    }
+
+    Error fail(ErrorCode code) {
+      close();
+      return {code};
+    }
+
+    // 改名记录在目录里，目录也要落盘，改名才不会在掉电后丢失
+    static bool syncDirectory(const char* path) {
+#if JSON_HAS_MMAP
+      std::string directory(path);
+      auto slash = directory.rfind('/');
+      directory = slash == std::string::npos ? "." : slash == 0 ? "/" : directory.substr(0, slash);
+      int fd = ::open(directory.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      bool synced = ::fsync(fd) == 0;
+      ::close(fd);
+      return synced;
+#else
+      (void)path;
+      return true;
+#endif
+    }
+
+  public:
+    // 先写到 path.tmp 并落盘，再改名并同步所在的目录，写到一半失败、进程退出或掉电都不会留下不完整的文件
+    // 不支持 fsync 的平台上只能保证前两种
+    // 改名之后目录同步失败时返回 IO，此时 path 已经是新文件，但不保证掉电后还在
+    static Error save(const JsonTape& tape, const char* path) {
+      Header header{};
+      std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+      header.version = VERSION;
+      header.byteOrder = ENDIAN_MARK;
+      header.tapeWords = tape.tape.size();
+      header.stringBytes = tape.strings.size();
+      header.tapeChecksum = checksum(tape.tape.data(), tape.tape.size() * sizeof(uint64_t));
+      header.stringsChecksum = checksum(tape.strings.data(), tape.strings.size());
+      header.headerChecksum = headerChecksum(header);
+
+      std::string temporary = std::string(path) + ".tmp";
+      std::FILE* stream = std::fopen(temporary.c_str(), "wb");
+      if (stream == nullptr) return {ErrorCode::IO};
+      bool written = std::fwrite(&header, sizeof(header), 1, stream) == 1
+                     && std::fwrite(tape.tape.data(), sizeof(uint64_t), tape.tape.size(), stream)
+                          == tape.tape.size()
+                     && std::fwrite(tape.strings.data(), 1, tape.strings.size(), stream)
+                          == tape.strings.size();
+      written = written && std::fflush(stream) == 0;
+#if JSON_HAS_MMAP
+      written = written && ::fsync(fileno(stream)) == 0;
+#endif
+      written = std::fclose(stream) == 0 && written;
+      if (!written || std::rename(temporary.c_str(), path) != 0) {
+        std::remove(temporary.c_str());
+        return {ErrorCode::IO};
+      }
+      if (!syncDirectory(path)) return {ErrorCode::IO};
+      return {};
+    }
+
+    // 映射文件并检查文件头；verify 为 true 时还会读一遍全部内容核对校验和
+    // verify 为 false 时打开的耗时与文件大小无关，但文件内容必须可信，损坏的 tape 会导致越界访问
+    // 出错时 root() 不存在
+    Error open(const char* path, bool verify = true) {
+      close();
+      if (!file.open(path)) return {ErrorCode::IO};
+      auto bytes = file.view();
+      if (bytes.size() < sizeof(Header)) return fail(ErrorCode::TRUNCATED);
+
+      Header header;
+      std::memcpy(&header, bytes.data(), sizeof(header));
+      if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail(ErrorCode::BAD_MAGIC);
+      // 先确认文件头完好，再相信其中的字节序和版本；字节序相反时校验和按本机字节序算也对不上，
+      // 所以校验失败时恰好是反序的标记才算字节序不同，其余都是损坏
+      if (header.headerChecksum != headerChecksum(header)) {
+        return fail(header.byteOrder == SWAPPED_MARK ? ErrorCode::BYTE_ORDER_MISMATCH
+                                                     : ErrorCode::BAD_HEADER);
+      }
+      if (header.byteOrder != ENDIAN_MARK) return fail(ErrorCode::BYTE_ORDER_MISMATCH);
+      if (header.version != VERSION) return fail(ErrorCode::UNSUPPORTED_VERSION);
+      // 先比较再相乘，避免损坏的长度溢出
+      size_t body = bytes.size() - sizeof(Header);
+      if (header.tapeWords > body / sizeof(uint64_t) ||
+          header.stringBytes != body - header.tapeWords * sizeof(uint64_t)) {
+        return fail(ErrorCode::TRUNCATED);
+      }
+
+      auto tape = reinterpret_cast<const uint64_t*>(bytes.data() + sizeof(Header));
+      auto strings = bytes.data() + sizeof(Header) + header.tapeWords * sizeof(uint64_t);
+      if (verify && (checksum(tape, header.tapeWords * sizeof(uint64_t)) != header.tapeChecksum ||
+                     checksum(strings, header.stringBytes) != header.stringsChecksum)) {
+        return fail(ErrorCode::CHECKSUM_MISMATCH);
+      }
+
+      // 查询只访问用到的部分，不需要预读
+      file.adviseRandom();
+      view = {tape, header.tapeWords, strings};
+      return {};
+    }
+
+    void close() {
+      file.close();
+      view = {};
+    }
+
+    JsonTape::Value root() const {
+      return JsonTape::Value(view, 0);
+    }
+};
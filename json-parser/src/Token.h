@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include "number.h"
 
 class Token {
   protected:
@@ -89,15 +91,53 @@ class StringToken : public Token {
     }
 };
 
+// value 是数值的原始文本，format 原样输出，不会因为转换丢失精度或改变写法
+// 数值在第一次取值时才解析，结果缓存下来；value 必须符合 JSON 的数值文法
 class NumberToken : public Token {
+  private:
+    mutable NumberKind numberKind = NumberKind::RAW;
+    mutable uint64_t payload = 0;
+
+    void materialize() const {
+      if (numberKind == NumberKind::RAW) numberKind = number::parse(this->value, payload);
+    }
+
   public:
     NumberToken(const std::string& value) : Token(value) {}
+    // 词法分析时已经解析过的数值直接带上结果，kind 为 RAW 时仍在第一次取值时解析
+    NumberToken(const std::string& value, NumberKind kind, uint64_t payload)
+        : Token(value),
+          numberKind(kind),
+          payload(payload) {}
     std::string format() const override {
       return this->value;
     }
     std::string display() const override {
       return "NumberToken(" + this->value + ")";
     }
+
+    NumberKind kind() const {
+      materialize();
+      return numberKind;
+    }
+
+    // 由调用方确保 kind 是 INT64
+    int64_t toInt64() const {
+      materialize();
+      return static_cast<int64_t>(payload);
+    }
+
+    // 由调用方确保 kind 是 UINT64，或者是非负的 INT64
+    uint64_t toUint64() const {
+      materialize();
+      return payload;
+    }
+
+    // 任何数值都可以取 double，整数会被舍入，超出范围的是 ±inf
+    double toDouble() const {
+      materialize();
+      return number::toDouble(numberKind, payload);
+    }
 };
 
 class BooleanToken : public Token {
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Token.h"
+#include "number.h"
+#include "util.h"
+
+enum class TokenType : uint8_t {
+  OBJECT_START,
+  OBJECT_END,
+  ARRAY_START,
+  ARRAY_END,
+  COLON,
+  COMMA,
+  STRING,
+  NUMBER,
+  BOOLEAN,
+  NULL_VALUE,
+};
+
+// 定长的 token 记录：没有虚表，也不单独分配内存，整段输入的 token 放在一块连续数组里
+struct TapeToken {
+  TokenType type;
+  uint8_t flags;
+  int16_t exponent;  // DECIMAL 的十进制指数，占用原本的对齐空隙；其余为 0
+  uint32_t length;   // token 在输入中占用的字节数（字符串包含两端引号）
+  uint64_t offset;   // token 在输入中的起始偏移
+  uint64_t payload;  // BOOLEAN：0/1；解析过的 NUMBER：见 NumberKind；其余为 0
+
+  // STRING 的 flags
+  static constexpr uint8_t HAS_ESCAPES = 1 << 0;  // 含有转义序列，需要解码
+  // NUMBER 的 flags 是 NumberKind
+};
+
+static_assert(sizeof(TapeToken) == 24);
+static_assert(std::is_trivially_copyable_v<TapeToken>);
+
+class TokenTape {
+  public:
+    std::vector<TapeToken> tokens;
+
+    void clear() {
+      tokens.clear();
+    }
+
+    size_t size() const {
+      return tokens.size();
+    }
+
+    void push(TokenType type, size_t offset, size_t length, uint64_t payload = 0, uint8_t flags = 0) {
+      tokens.push_back({type, flags, 0, static_cast<uint32_t>(length), offset, payload});
+    }
+
+    void pushNumber(size_t offset, size_t length, NumberKind kind, uint64_t payload, int16_t exponent) {
+      tokens.push_back({TokenType::NUMBER,
+                        static_cast<uint8_t>(kind),
+                        exponent,
+                        static_cast<uint32_t>(length),
+                        offset,
+                        payload});
+    }
+
+    void pushString(size_t offset, size_t length, bool hasEscapes) {
+      push(TokenType::STRING, offset, length, 0, hasEscapes ? TapeToken::HAS_ESCAPES : 0);
+    }
+
+    // 字符串在输入中的原始内容（不含两端引号），不做任何拷贝
+    // 由调用方确保 token 是 STRING
+    static std::string_view rawString(const TapeToken& token, std::string_view input) {
+      return input.substr(token.offset + 1, token.length - 2);
+    }
+
+    // 不含转义的字符串直接返回指向输入的视图，否则解码到 scratch 中再返回 scratch 的视图
+    // 由调用方确保 token 是 STRING
+    static std::string_view string(const TapeToken& token,
+                                   std::string_view input,
+                                   std::string& scratch) {
+      auto raw = rawString(token, input);
+      if (!(token.flags & TapeToken::HAS_ESCAPES)) {
+        return raw;
+      }
+      scratch.clear();
+      util::appendUnescaped(raw, scratch);
+      return scratch;
+    }
+
+    // 没有开启数值解析时是 RAW，由调用方确保 token 是 NUMBER
+    static NumberKind numberKind(const TapeToken& token) {
+      return static_cast<NumberKind>(token.flags);
+    }
+
+    // 数值在输入中的原始文本，解析与否都不受影响，可以原样写回输出
+    // 由调用方确保 token 是 NUMBER
+    static std::string_view rawNumber(const TapeToken& token, std::string_view input) {
+      return input.substr(token.offset, token.length);
+    }
+
+    // 没有解析过的数值在第一次访问时解析，结果存回 token，之后直接读取
+    // 只转发不读取的数值不需要付出转换的代价；由调用方确保 token 是 NUMBER，input 是生成它的输入
+    static NumberKind materialize(TapeToken& token, std::string_view input) {
+      if (numberKind(token) == NumberKind::RAW) {
+        token.flags = static_cast<uint8_t>(number::parse(rawNumber(token, input), token.payload));
+      }
+      return numberKind(token);
+    }
+
+    // 由调用方确保 numberKind 是 INT64
+    static int64_t int64(const TapeToken& token) {
+      return static_cast<int64_t>(token.payload);
+    }
+
+    // 由调用方确保 numberKind 是 UINT64，或者是非负的 INT64
+    static uint64_t uint64(const TapeToken& token) {
+      return token.payload;
+    }
+
+    // 任何解析过的数值都可以转换成 double，由调用方确保 numberKind 不是 RAW 或 BIG_DECIMAL
+    static double toDouble(const TapeToken& token) {
+      if (numberKind(token) == NumberKind::DECIMAL) {
+        auto value = decimal(token);
+        auto magnitude = value.mantissa < 0 ? 0 - static_cast<uint64_t>(value.mantissa)
+                                            : static_cast<uint64_t>(value.mantissa);
+        auto bits = number::toDoubleBits(magnitude, value.exponent, false, {});
+        return number::fromBits(bits | (value.mantissa < 0 ? number::SIGN_BIT : 0));
+      }
+      return number::toDouble(numberKind(token), token.payload);
+    }
+
+    // 由调用方确保 numberKind 是 DECIMAL
+    static number::Decimal decimal(const TapeToken& token) {
+      return {static_cast<int64_t>(token.payload), token.exponent};
+    }
+
+    // 任何 NUMBER 都可以从原始文本得到精确的值，BIG_DECIMAL 只能这样取值
+    static number::BigDecimal bigDecimal(const TapeToken& token, std::string_view input) {
+      return number::BigDecimal::parse(rawNumber(token, input));
+    }
+
+    // 在紧凑表示上构造原有的 Token 对象，input 必须是生成这份 tape 的输入
+    static std::unique_ptr<Token> toToken(const TapeToken& token, std::string_view input) {
+      switch (token.type) {
+        case TokenType::OBJECT_START:
+          return std::make_unique<ObjectStartToken>();
+        case TokenType::OBJECT_END:
+          return std::make_unique<ObjectEndToken>();
+        case TokenType::ARRAY_START:
+          return std::make_unique<ArrayStartToken>();
+        case TokenType::ARRAY_END:
+          return std::make_unique<ArrayEndToken>();
+        case TokenType::COLON:
+          return std::make_unique<ColonToken>();
+        case TokenType::COMMA:
+          return std::make_unique<CommaToken>();
+        case TokenType::STRING: {
+          std::string scratch;
+          return std::make_unique<StringToken>(std::string(string(token, input, scratch)));
+        }
+        case TokenType::NUMBER: {
+          // NumberToken 按 double 取值，精确十进制的结果不能直接交给它
+          auto kind = numberKind(token);
+          bool exact = kind == NumberKind::DECIMAL || kind == NumberKind::BIG_DECIMAL;
+          return std::make_unique<NumberToken>(std::string(rawNumber(token, input)),
+                                               exact ? NumberKind::RAW : kind,
+                                               token.payload);
+        }
+        case TokenType::BOOLEAN:
+          return std::make_unique<BooleanToken>(token.payload != 0);
+        case TokenType::NULL_VALUE:
+          return std::make_unique<NullToken>();
+      }
+      return nullptr;
+    }
+};
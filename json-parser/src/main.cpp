@@ -1,7 +1,162 @@
+#include <cstdio>
+#include <cstring>
 #include <spdlog/spdlog.h>
+#include "JsonDocument.h"
 #include "JsonLexer.h"
+#include "MappedFile.h"
 
+namespace {
+  void printToken(const TapeToken& token, std::string_view input) {
+    spdlog::info("{}", TokenTape::toToken(token, input)->display());
+  }
+
+  // input 是整个输入时提示中带上出错处的内容
+  [[noreturn]] void fail(const JsonLexer::Error& error, std::string_view input = {}) {
+    spdlog::info("第 {} 字节：{}", error.offset, error.message(input));
+    exit(1);
+  }
+
+  // 普通文件：直接在映射的字节上用游标逐个取 token，内存占用与文件大小无关
+  size_t lexMapped(std::string_view input, JsonLexer::Options options, bool print) {
+    JsonLexer lexer(options);
+    size_t count = 0;
+    auto cursor = lexer.cursor(input);
+    for (const auto& token : cursor) {
+      if (print) printToken(token, input);
+      ++count;
+    }
+    if (cursor.error()) fail(cursor.error(), input);
+    return count;
+  }
+
+  // 管道和标准输入不能映射，按块读取后交给推送模式，不需要把整个输入拼成一个字符串
+  size_t lexStream(std::FILE* file, JsonLexer::Options options, bool print) {
+    JsonLexer lexer(options);
+    size_t count = 0;
+    auto onToken = [&](const TapeToken& token, std::string_view text) {
+      if (print) {
+        // text 只包含这个 token 本身
+        auto local = token;
+        local.offset = 0;
+        printToken(local, text);
+      }
+      ++count;
+    };
+
+    std::vector<char> chunk(1 << 20);
+    size_t n;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+      // 读过的 chunk 不再保留，提示中只有错误的种类和位置
+      if (auto error = lexer.feed(std::string_view(chunk.data(), n), onToken)) fail(error);
+    }
+    if (std::ferror(file)) {
+      spdlog::info("读取输入失败");
+      exit(1);
+    }
+    if (auto error = lexer.finish(onToken)) fail(error);
+    return count;
+  }
+
+  // 建立整个文档的 DOM，同时检查 token 的排列是否符合 JSON 文法，返回节点数
+  size_t buildDocument(std::string_view input) {
+    JsonDocument document;
+    if (auto error = document.parse(input)) {
+      spdlog::info("第 {} 字节：{}", error.offset, error.message(input));
+      exit(1);
+    }
+    // 遍历同样用显式的栈，嵌套再深也不会栈溢出
+    size_t count = 0;
+    std::vector<const JsonValue*> stack{&document.root()};
+    while (!stack.empty()) {
+      auto value = stack.back();
+      stack.pop_back();
+      ++count;
+      if (value->type() == JsonType::ARRAY) {
+        for (const auto& element : value->elements()) stack.push_back(&element);
+      } else if (value->type() == JsonType::OBJECT) {
+        for (const auto& member : value->members()) stack.push_back(&member.value);
+      }
+    }
+    return count;
+  }
+
+  std::string readAll(std::FILE* file) {
+    std::string input;
+    std::vector<char> chunk(1 << 20);
+    size_t n;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) input.append(chunk.data(), n);
+    if (std::ferror(file)) {
+      spdlog::info("读取输入失败");
+      exit(1);
+    }
+    return input;
+  }
+}
+
+// json-parser [--print] [--huge-pages] [--trusted] [--dom] <file | ->
+// --trusted：确知输入合法，跳过字符串内容的 UTF-8 和控制字符检查
+// --dom：建立 DOM 并检查文法，输出节点数；需要把整个输入读进内存
+// 不带参数时分析内置的示例
 int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    bool print = false, hugePages = false, dom = false;
+    JsonLexer::Options options;
+    const char* path = nullptr;
+    for (int k = 1; k < argc; ++k) {
+      if (std::strcmp(argv[k], "--print") == 0) {
+        print = true;
+      } else if (std::strcmp(argv[k], "--huge-pages") == 0) {
+        hugePages = true;
+      } else if (std::strcmp(argv[k], "--trusted") == 0) {
+        options.validateStrings = false;
+      } else if (std::strcmp(argv[k], "--dom") == 0) {
+        dom = true;
+      } else {
+        path = argv[k];
+      }
+    }
+    if (path == nullptr) {
+      spdlog::info("用法：{} [--print] [--huge-pages] [--trusted] [--dom] <file | ->", argv[0]);
+      return 1;
+    }
+
+    if (dom) {
+      MappedFile file;
+      size_t count;
+      if (std::strcmp(path, "-") != 0 && file.open(path, hugePages)) {
+        count = buildDocument(file.view());
+      } else {
+        std::FILE* stream = std::strcmp(path, "-") == 0 ? stdin : std::fopen(path, "rb");
+        if (stream == nullptr) {
+          spdlog::info("无法打开文件：{}", path);
+          return 1;
+        }
+        count = buildDocument(readAll(stream));
+        if (stream != stdin) std::fclose(stream);
+      }
+      spdlog::info("节点数：{}", count);
+      return 0;
+    }
+
+    size_t count;
+    MappedFile file;
+    if (std::strcmp(path, "-") == 0) {
+      count = lexStream(stdin, options, print);
+    } else if (file.open(path, hugePages)) {
+      count = lexMapped(file.view(), options, print);
+    } else {
+      std::FILE* stream = std::fopen(path, "rb");
+      if (stream == nullptr) {
+        spdlog::info("无法打开文件：{}", path);
+        return 1;
+      }
+      count = lexStream(stream, options, print);
+      std::fclose(stream);
+    }
+    spdlog::info("token 数：{}", count);
+    return 0;
+  }
+
   std::string input = R"(
     {
       "object": {
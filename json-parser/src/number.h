@@ -0,0 +1,537 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "simd.h"
+#include "util.h"
+
+#if !defined(__cpp_lib_to_chars) && (defined(__unix__) || defined(__APPLE__))
+  #include <locale.h>
+  #if defined(__APPLE__)
+    #include <xlocale.h>
+  #endif
+#endif
+
+// 解析后的数值类别，记在 NUMBER token 的 flags 中
+enum class NumberKind : uint8_t {
+  RAW,     // 没有解析，只有原始文本
+  INT64,   // 能放进 int64 的整数，payload 是 int64_t；-0 不算，它是 DOUBLE 以保留符号
+  UINT64,  // 超出 int64 但能放进 uint64 的整数，payload 是 uint64_t
+  DOUBLE,  // 带小数点或指数的数，payload 是 double 的位
+  BIG,     // 超出 64 位的整数，payload 是与它最接近的 double 的位
+
+  // 精确十进制模式下带小数点或指数的数
+  DECIMAL,      // 尾数能放进 int64、指数能放进 int16，payload 是 int64_t 尾数，指数另外存放
+  BIG_DECIMAL,  // 超出 DECIMAL 的范围，只能从原始文本用 number::BigDecimal 取得
+};
+
+// 十进制文本到二进制数值的转换
+// 整数在能放进 64 位时精确保存，其余按 IEEE 754 就近舍入到 double：
+// 先试 Clinger 的快速路径，再用 Eisel-Lemire 算法，只有超过 19 位有效数字且无法判定舍入方向时才调用 strtod
+namespace number {
+  constexpr int SMALLEST_POWER_OF_TEN = -342;
+  constexpr int LARGEST_POWER_OF_TEN = 308;
+  constexpr uint64_t INFINITY_BITS = 0x7FF0000000000000ULL;
+  constexpr uint64_t SIGN_BIT = 1ULL << 63;
+  constexpr int MANTISSA_BITS = 52;
+
+  namespace detail {
+    // 编译期生成 5 的幂表用的定长大整数，低位在前
+    struct BigInt {
+      static constexpr int LIMBS = 56;
+      uint32_t limbs[LIMBS] = {};
+      int size = 0;  // 用到的 limb 个数，更高的 limb 都是 0
+
+      constexpr void multiply(uint32_t m) {
+        uint64_t carry = 0;
+        for (int k = 0; k < size; ++k) {
+          uint64_t x = uint64_t(limbs[k]) * m + carry;
+          limbs[k] = static_cast<uint32_t>(x);
+          carry = x >> 32;
+        }
+        if (carry != 0) limbs[size++] = static_cast<uint32_t>(carry);
+      }
+
+      constexpr void divide(uint32_t d) {
+        uint64_t remainder = 0;
+        for (int k = size; k-- > 0;) {
+          uint64_t x = remainder << 32 | limbs[k];
+          limbs[k] = static_cast<uint32_t>(x / d);
+          remainder = x % d;
+        }
+        while (size > 0 && limbs[size - 1] == 0) size--;
+      }
+
+      constexpr int bitLength() const {
+        if (size == 0) return 0;
+        int n = 32;
+        while (!(limbs[size - 1] >> (n - 1) & 1)) n--;
+        return (size - 1) * 32 + n;
+      }
+
+      constexpr uint32_t limb(int k) const {
+        return 0 <= k && k < size ? limbs[k] : 0;
+      }
+
+      constexpr bool bit(int pos) const {
+        return limb(pos / 32) >> (pos % 32) & 1;
+      }
+
+      // 第 from 位到第 to 位（不含）是否全是 1
+      constexpr bool allOnes(int from, int to) const {
+        for (int pos = from; pos < to; ++pos) {
+          if (!bit(pos)) return false;
+        }
+        return true;
+      }
+
+      // 右移 shift 位之后的低 64 位，shift 为负时左移
+      constexpr uint64_t bits64(int shift) const {
+        if (shift < 0) return -shift < 64 ? bits64(0) << -shift : 0;
+        int k = shift / 32, b = shift % 32;
+        uint64_t low = limb(k) | uint64_t(limb(k + 1)) << 32;
+        return b == 0 ? low : (low >> b | uint64_t(limb(k + 2)) << (64 - b));
+      }
+    };
+
+    // 10^q 的 128 位近似，q 从 SMALLEST_POWER_OF_TEN 到 LARGEST_POWER_OF_TEN，每项两个 uint64，高位在前
+    // 二进制指数由 q 直接算出，所以表中只需要 5^q 的有效位：
+    // q >= 0 时是 5^q 截断后的最高 128 位，q < 0 时是 2^b / 5^-q 向下取整加一后截断的 128 位
+    inline const uint64_t* powersOfFive() {
+      constexpr int count = LARGEST_POWER_OF_TEN - SMALLEST_POWER_OF_TEN + 1;
+      static constexpr auto table = []() {
+        std::array<uint64_t, 2 * count> table{};
+        // floor(2^B / 5^k) 由 2^B 逐次除以 5 得到，B 要大于用到的最大的 b
+        constexpr int B = 1728;
+        BigInt power, reciprocal;
+        power.limbs[0] = 1;
+        power.size = 1;
+        reciprocal.limbs[B / 32] = 1u << (B % 32);
+        reciprocal.size = B / 32 + 1;
+
+        for (int k = 0; k <= -SMALLEST_POWER_OF_TEN; ++k) {
+          if (k > 0) {
+            power.multiply(5);
+            reciprocal.divide(5);
+          }
+          int length = power.bitLength();
+          if (k <= LARGEST_POWER_OF_TEN) {
+            size_t index = 2 * static_cast<size_t>(k - SMALLEST_POWER_OF_TEN);
+            table[index] = power.bits64(length - 64);
+            table[index + 1] = power.bits64(length - 128);
+          }
+          if (k > 0) {
+            // c = floor(2^b / 5^k) + 1 = (reciprocal >> from) + 1，超过 128 位时再右移 shift 位
+            int b = k <= 27 ? length + 127 : 2 * length + 128;
+            int from = B - b, top = reciprocal.bitLength();
+            // 只有被加的数全是 1 时加一才会进位到更高一位
+            int cLength = top - from + (reciprocal.allOnes(from, top) ? 1 : 0);
+            int shift = cLength > 128 ? cLength - 128 : 0;
+            uint64_t high = reciprocal.bits64(from + shift + 64);
+            uint64_t low = reciprocal.bits64(from + shift);
+            // 右移掉的低位全是 1 时，加一的进位会传到保留的部分
+            if (reciprocal.allOnes(from, from + shift) && ++low == 0) high++;
+            size_t index = 2 * static_cast<size_t>(-k - SMALLEST_POWER_OF_TEN);
+            table[index] = high;
+            table[index + 1] = low;
+          }
+        }
+        return table;
+      }();
+      return table.data();
+    }
+
+    struct Uint128 {
+      uint64_t low;
+      uint64_t high;
+    };
+
+    inline Uint128 multiply(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+      __extension__ using uint128 = unsigned __int128;
+      auto r = static_cast<uint128>(a) * b;
+      return {static_cast<uint64_t>(r), static_cast<uint64_t>(r >> 64)};
+#else
+      uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32;
+      uint64_t bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+      uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh;
+      uint64_t highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+      uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+      return {(middle << 32) | (lowLow & 0xFFFFFFFF),
+              highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32)};
+#endif
+    }
+  }
+
+  inline double fromBits(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+  }
+
+  inline uint64_t toBits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(d));
+    return bits;
+  }
+
+  // Eisel-Lemire：w × 10^q 就近舍入后的 double 的位（不含符号），w 不超过 19 位十进制数
+  // 乘积的截断误差不会影响舍入结果，所以不需要回退
+  inline uint64_t eiselLemire(uint64_t w, int64_t q) {
+    if (w == 0 || q < SMALLEST_POWER_OF_TEN) return 0;
+    if (q > LARGEST_POWER_OF_TEN) return INFINITY_BITS;
+
+    int lz = simd::leadingZeros(w);
+    w <<= lz;
+    auto powers = detail::powersOfFive();
+    size_t index = 2 * static_cast<size_t>(q - SMALLEST_POWER_OF_TEN);
+    auto product = detail::multiply(w, powers[index]);
+    // 高位中舍入需要的 55 位以下全是 1 时，低 64 位的进位可能影响结果，再乘上表中的低半部分
+    constexpr uint64_t precisionMask = ~0ULL >> (MANTISSA_BITS + 3);
+    if ((product.high & precisionMask) == precisionMask) {
+      auto second = detail::multiply(w, powers[index + 1]);
+      product.low += second.high;
+      if (second.high > product.low) product.high++;
+    }
+
+    int upperBit = static_cast<int>(product.high >> 63);
+    int shift = upperBit + 64 - MANTISSA_BITS - 3;
+    uint64_t mantissa = product.high >> shift;
+    // floor(log2(10^q)) 的近似是 (217706 * q) >> 16
+    int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upperBit - lz + 1023;
+
+    if (power2 <= 0) {
+      // 非规格化数
+      if (-power2 + 1 >= 64) return 0;
+      mantissa >>= -power2 + 1;
+      mantissa += mantissa & 1;
+      mantissa >>= 1;
+      // 舍入后可能进位成最小的规格化数
+      power2 = mantissa < (1ULL << MANTISSA_BITS) ? 0 : 1;
+      return mantissa | static_cast<uint64_t>(power2) << MANTISSA_BITS;
+    }
+
+    // 恰好在两个 double 中间时向偶数舍入，只有 q 在 [-4, 23] 内才可能出现
+    if (product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1
+        && (mantissa << shift) == product.high) {
+      mantissa &= ~1ULL;
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << MANTISSA_BITS)) {
+      mantissa = 1ULL << MANTISSA_BITS;
+      power2++;
+    }
+    mantissa &= ~(1ULL << MANTISSA_BITS);
+    if (power2 >= 0x7FF) return INFINITY_BITS;
+    return mantissa | static_cast<uint64_t>(power2) << MANTISSA_BITS;
+  }
+
+  // 完整的十进制文本就近舍入成 double，与 locale 无关（strtod 在小数点是 ',' 的 locale 下会读错）
+  // 上溢或下溢到 0 时 from_chars 不给出结果，返回 false
+  inline bool parseSlow(std::string_view text, double& d) {
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(text.data(), text.data() + text.size(), d);
+    return result.ec != std::errc::result_out_of_range;
+#elif defined(__unix__) || defined(__APPLE__)
+    static locale_t c = newlocale(LC_ALL_MASK, "C", nullptr);
+    d = strtod_l(std::string(text).c_str(), nullptr, c);
+    return true;
+#else
+    d = std::strtod(std::string(text).c_str(), nullptr);
+    return true;
+#endif
+  }
+
+  // w × 10^q 就近舍入后的 double 的位（不含符号）
+  // truncated 表示 w 只是前 19 位有效数字，后面还有被舍去的数字，此时 text 是完整的原始文本
+  inline uint64_t toDoubleBits(uint64_t w, int64_t q, bool truncated, std::string_view text) {
+    static constexpr double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                             1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                             1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (!truncated) {
+      // w 和 10^|q| 都能精确表示成 double，一次乘除的结果就是正确舍入的
+      if (w <= (1ULL << 53) && -22 <= q && q <= 22) {
+        double d = static_cast<double>(w);
+        d = q < 0 ? d / powersOfTen[-q] : d * powersOfTen[q];
+        return toBits(d);
+      }
+      return eiselLemire(w, q);
+    }
+
+    // 真实值在 w × 10^q 和 (w + 1) × 10^q 之间，两端舍入到同一个 double 时就是结果
+    auto bits = eiselLemire(w, q);
+    if (bits == eiselLemire(w + 1, q)) return bits;
+    double d = 0;
+    // 超出范围时真实值远离 1，q 的符号就说明了方向
+    if (!parseSlow(text, d)) return q < 0 ? 0 : toBits(std::numeric_limits<double>::infinity());
+    return toBits(d) & ~SIGN_BIT;
+  }
+
+  // 解析结果对应的 double，整数会被舍入；由调用方确保 kind 是 INT64、UINT64、DOUBLE 或 BIG
+  inline double toDouble(NumberKind kind, uint64_t payload) {
+    switch (kind) {
+      case NumberKind::INT64:
+        return static_cast<double>(static_cast<int64_t>(payload));
+      case NumberKind::UINT64:
+        return static_cast<double>(payload);
+      default:
+        return fromBits(payload);
+    }
+  }
+
+  // 从 p 开始每次取 8 个数字累加到 w，返回剩下不足 8 个数字的位置；溢出时按 2^64 回绕，与逐位累加的结果相同
+  inline const char* accumulateDigits(const char* p, const char* end, uint64_t& w) {
+    while (p + 8 <= end) {
+      auto x = simd::swarLoad(p);
+      if (!simd::swarAllDigits(x)) break;
+      w = w * 100000000 + simd::swarParseEightDigits(x);
+      p += 8;
+    }
+    return p;
+  }
+
+  // 解析数值文本，返回类别，值写入 payload；由调用方确保 text 符合 JSON 的数值文法
+  inline NumberKind parse(std::string_view text, uint64_t& payload) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    bool negative = *p == '-';
+    if (negative) ++p;
+
+    // 按整数累加所有数字，超过 19 位时会溢出，之后再处理；成段的数字每次累加 8 位
+    uint64_t w = 0;
+    const char* intStart = p;
+    p = accumulateDigits(p, end, w);
+    while (p < end && util::isDigit(*p)) {
+      w = w * 10 + static_cast<uint64_t>(*p - '0');
+      ++p;
+    }
+    const char* intEnd = p;
+    size_t intDigits = static_cast<size_t>(intEnd - intStart);
+
+    bool integer = p == end;
+    if (integer) {
+      // 整数；JSON 不允许前导零，位数就是有效数字的个数
+      bool fits = intDigits <= 19;
+      if (intDigits == 20) {
+        // 前 19 位不会溢出，只需检查最后一位
+        uint64_t head = 0;
+        for (const char* q = intStart; q < intEnd - 1; ++q) head = head * 10 + static_cast<uint64_t>(*q - '0');
+        auto last = static_cast<uint64_t>(intEnd[-1] - '0');
+        constexpr uint64_t limit = UINT64_MAX / 10;
+        fits = head < limit || (head == limit && last <= UINT64_MAX % 10);
+      }
+      if (fits && !negative) {
+        payload = w;
+        return w <= static_cast<uint64_t>(INT64_MAX) ? NumberKind::INT64 : NumberKind::UINT64;
+      }
+      // -0 按浮点数处理，否则 toDouble 得到的是 +0
+      if (fits && w <= SIGN_BIT && w != 0) {
+        payload = 0 - w;
+        return NumberKind::INT64;
+      }
+    }
+
+    const char* fracStart = p;
+    const char* fracEnd = p;
+    int64_t q = 0;
+    if (p < end && *p == '.') {
+      fracStart = ++p;
+      p = accumulateDigits(p, end, w);
+      while (p < end && util::isDigit(*p)) {
+        w = w * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+      }
+      fracEnd = p;
+      q = fracStart - fracEnd;
+    }
+
+    if (p < end) {
+      // 指数，位数过多时只需要知道它足够大
+      ++p;
+      bool negativeExponent = *p == '-';
+      if (*p == '-' || *p == '+') ++p;
+      int64_t exponent = 0;
+      for (; p < end; ++p) {
+        if (exponent < 0x10000) exponent = exponent * 10 + (*p - '0');
+      }
+      q += negativeExponent ? -exponent : exponent;
+    }
+
+    // 有效数字超过 19 位时只取前 19 位，用 truncated 标记
+    bool truncated = false;
+    size_t digits = intDigits + static_cast<size_t>(fracEnd - fracStart);
+    if (digits > 19) {
+      // 前导零不是有效数字
+      const char* start = intStart;
+      while (start < fracEnd && (*start == '0' || *start == '.')) {
+        if (*start == '0') digits--;
+        ++start;
+      }
+      if (digits > 19) {
+        truncated = true;
+        w = 0;
+        size_t taken = 0;
+        const char* t = start;
+        for (; t < intEnd && taken < 19; ++t, ++taken) w = w * 10 + static_cast<uint64_t>(*t - '0');
+        if (t < intEnd) {
+          // 整数部分就已经够 19 位，小数位全部舍去，舍去的整数位让数量级变大
+          q += (fracEnd - fracStart) + (intEnd - t);
+        } else {
+          if (t < fracStart) t = fracStart;
+          for (; t < fracEnd && taken < 19; ++t, ++taken) w = w * 10 + static_cast<uint64_t>(*t - '0');
+          q += fracEnd - t;
+        }
+      }
+    }
+
+    payload = toDoubleBits(w, q, truncated, text) | (negative ? SIGN_BIT : 0);
+    // 走到这里的整数要么超出 64 位（w 是前 19 位，不为 0），要么是 -0
+    return integer && w != 0 ? NumberKind::BIG : NumberKind::DOUBLE;
+  }
+
+  // 精确的十进制数 mantissa × 10^exponent，保留原文的小数位数，1.50 是 150 × 10^-2
+  struct Decimal {
+    int64_t mantissa;
+    int16_t exponent;
+  };
+
+  // 任意精度的十进制数 ±coefficient × 10^exponent，coefficient 按 10^9 进制存放，低位在前，为 0 时为空
+  struct BigDecimal {
+    bool negative = false;
+    std::vector<uint32_t> coefficient;
+    int64_t exponent = 0;
+
+    // 由调用方确保 text 符合 JSON 的数值文法；指数大到不可能有意义时会被截断
+    static BigDecimal parse(std::string_view text) {
+      BigDecimal result;
+      const char* p = text.data();
+      const char* end = p + text.size();
+      result.negative = *p == '-';
+      if (result.negative) ++p;
+
+      // 每 9 位数字乘进一次
+      uint32_t chunk = 0, scale = 1;
+      auto flushChunk = [&]() {
+        uint64_t carry = chunk;
+        for (auto& limb : result.coefficient) {
+          uint64_t x = uint64_t(limb) * scale + carry;
+          limb = static_cast<uint32_t>(x % 1000000000);
+          carry = x / 1000000000;
+        }
+        if (carry != 0) result.coefficient.push_back(static_cast<uint32_t>(carry));
+        chunk = 0;
+        scale = 1;
+      };
+      auto digit = [&](char c) {
+        chunk = chunk * 10 + static_cast<uint32_t>(c - '0');
+        scale *= 10;
+        if (scale == 1000000000) flushChunk();
+      };
+
+      for (; p < end && util::isDigit(*p); ++p) digit(*p);
+      if (p < end && *p == '.') {
+        for (++p; p < end && util::isDigit(*p); ++p) {
+          digit(*p);
+          result.exponent--;
+        }
+      }
+      flushChunk();
+
+      if (p < end) {
+        ++p;
+        bool negativeExponent = *p == '-';
+        if (*p == '-' || *p == '+') ++p;
+        int64_t exponent = 0;
+        for (; p < end; ++p) {
+          if (exponent < 100000000000000000LL) exponent = exponent * 10 + (*p - '0');
+        }
+        result.exponent += negativeExponent ? -exponent : exponent;
+      }
+      return result;
+    }
+
+    // 写成 JSON 数值，例如 123.456e789 写成 123456e786，数值与原文完全相同
+    std::string toString() const {
+      std::string out = negative ? "-" : "";
+      if (coefficient.empty()) return out + "0";
+      out += std::to_string(coefficient.back());
+      for (size_t k = coefficient.size() - 1; k-- > 0;) {
+        auto limb = std::to_string(coefficient[k]);
+        out.append(9 - limb.size(), '0');
+        out += limb;
+      }
+      if (exponent != 0) out += "e" + std::to_string(exponent);
+      return out;
+    }
+  };
+
+  // 精确十进制模式：整数与 parse 相同（超出 64 位的是 BIG_DECIMAL，-0 是 DOUBLE），其余的数不转换成 double，
+  // 尾数写入 payload、指数写入 exponent，放不下时是 BIG_DECIMAL；由调用方确保 text 符合 JSON 的数值文法
+  // 小数和带指数的数是 BIG_DECIMAL 时 payload 和 exponent 都是 0，结果只取决于 text
+  inline NumberKind parseDecimal(std::string_view text, uint64_t& payload, int16_t& exponent) {
+    payload = 0;
+    exponent = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    bool negative = *p == '-';
+    if (negative) ++p;
+
+    const char* intStart = p;
+    p = simd::skipDigits(p, end);
+    if (p == end) {
+      auto kind = parse(text, payload);
+      return kind == NumberKind::BIG ? NumberKind::BIG_DECIMAL : kind;
+    }
+
+    const char* intEnd = p;
+    const char* fracStart = p;
+    const char* fracEnd = p;
+    if (*p == '.') {
+      fracStart = ++p;
+      p = fracEnd = simd::skipDigits(p, end);
+    }
+    // 整数部分和小数部分的数字连起来就是尾数
+    // 不超过 18 位的数字不会溢出，更长的逐位检查是否超出 int64
+    uint64_t w = 0;
+    bool small = (intEnd - intStart) + (fracEnd - fracStart) <= 18;
+    auto addDigits = [&](const char* q, const char* to) {
+      if (small) {
+        for (q = accumulateDigits(q, to, w); q < to; ++q) w = w * 10 + static_cast<uint64_t>(*q - '0');
+        return true;
+      }
+      constexpr uint64_t limit = static_cast<uint64_t>(INT64_MAX);
+      for (; q < to; ++q) {
+        auto d = static_cast<uint64_t>(*q - '0');
+        if (w > (limit - d) / 10) return false;
+        w = w * 10 + d;
+      }
+      return true;
+    };
+    if (!addDigits(intStart, intEnd) || !addDigits(fracStart, fracEnd)) return NumberKind::BIG_DECIMAL;
+
+    int64_t e = fracStart - fracEnd;
+    if (p < end) {
+      ++p;
+      bool negativeExponent = *p == '-';
+      if (*p == '-' || *p == '+') ++p;
+      int64_t explicitExponent = 0;
+      for (; p < end; ++p) {
+        if (explicitExponent < 0x10000) explicitExponent = explicitExponent * 10 + (*p - '0');
+      }
+      e += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (e < INT16_MIN || e > INT16_MAX) return NumberKind::BIG_DECIMAL;
+
+    payload = negative ? 0 - w : w;
+    exponent = static_cast<int16_t>(e);
+    return NumberKind::DECIMAL;
+  }
+}
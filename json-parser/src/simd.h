@@ -0,0 +1,808 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #define JSON_SIMD_X86 1
+  #include <immintrin.h>
+  // 单个函数按需开启指令集，整个工程仍按默认目标编译，运行时再根据 CPU 选择内核
+  #define JSON_TARGET(features) __attribute__((target(features)))
+#else
+  #define JSON_SIMD_X86 0
+  #define JSON_TARGET(features)
+#endif
+
+namespace simd {
+  enum class Kernel {
+    SCALAR,
+    SSE42,
+    AVX2,
+  };
+
+  // 当前 CPU 支持的最快内核，只检测一次
+  inline Kernel bestKernel() {
+#if JSON_SIMD_X86
+    static const Kernel kernel = []() {
+      __builtin_cpu_init();
+      if (!__builtin_cpu_supports("pclmul")) return Kernel::SCALAR;
+      if (__builtin_cpu_supports("avx2")) return Kernel::AVX2;
+      if (__builtin_cpu_supports("sse4.2")) return Kernel::SSE42;
+      return Kernel::SCALAR;
+    }();
+    return kernel;
+#else
+    return Kernel::SCALAR;
+#endif
+  }
+
+  inline int trailingZeros(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+    while (!(bits & 1)) {
+      bits >>= 1;
+      ++n;
+    }
+    return n;
+#endif
+  }
+
+  // bits 不能为 0
+  inline int leadingZeros(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_clzll(bits);
+#else
+    int n = 0;
+    while (!(bits >> 63)) {
+      bits <<= 1;
+      ++n;
+    }
+    return n;
+#endif
+  }
+
+  inline int popCount(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    int n = 0;
+    for (; bits != 0; bits &= bits - 1) ++n;
+    return n;
+#endif
+  }
+
+  // 8 字节为一组的 SWAR：结果中字节的最高位表示该字节满足条件
+  // 借位会让命中字节之后的高地址字节误报，所以只有地址最低的命中是准确的
+  inline uint64_t swarLoad(const char* p) {
+    uint64_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+  }
+
+  // 不对齐地读入 4 字节，与 word32 打包的常量比较即可一次判断 4 个字符
+  inline uint32_t load32(const char* p) {
+    uint32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+  }
+
+  // 按小端把 4 个字符打包成整数，与 load32 读入的结果一致
+  constexpr uint32_t word32(const char (&s)[5]) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(s[0]))
+           | static_cast<uint32_t>(static_cast<uint8_t>(s[1])) << 8
+           | static_cast<uint32_t>(static_cast<uint8_t>(s[2])) << 16
+           | static_cast<uint32_t>(static_cast<uint8_t>(s[3])) << 24;
+  }
+
+  constexpr uint64_t swarBroadcast(uint8_t c) {
+    return 0x0101010101010101ULL * c;
+  }
+
+  // 等于 0 的字节
+  constexpr uint64_t swarZeroBytes(uint64_t x) {
+    return (x - swarBroadcast(0x01)) & ~x & swarBroadcast(0x80);
+  }
+
+  // 小于 n 的字节，n 不超过 128
+  constexpr uint64_t swarLessThan(uint64_t x, uint8_t n) {
+    return (x - swarBroadcast(n)) & ~x & swarBroadcast(0x80);
+  }
+
+  // 返回位于最低地址的命中字节在这一组中的下标，只适用于小端
+  inline int swarFirstByte(uint64_t hits) {
+    return trailingZeros(hits) / 8;
+  }
+
+  // 字符串内容中需要状态机处理的字节：'"'、'\\' 和小于 0x20 的控制字符
+  inline uint64_t swarStringSpecial(uint64_t x) {
+    return swarZeroBytes(x ^ swarBroadcast('"')) | swarZeroBytes(x ^ swarBroadcast('\\'))
+           | swarLessThan(x, 0x20);
+  }
+
+  // 标量版本，每次处理 8 字节
+  inline const char* findStringSpecialSwar(const char* p, const char* end) {
+    for (; p + 8 <= end; p += 8) {
+      auto hits = swarStringSpecial(swarLoad(p));
+      if (hits) return p + swarFirstByte(hits);
+    }
+    for (; p < end; ++p) {
+      auto c = static_cast<uint8_t>(*p);
+      if (c == '"' || c == '\\' || c < 0x20) return p;
+    }
+    return end;
+  }
+
+  // 在 [p, end) 中找第一个非空白字节，没有则返回 end
+  // 缩进几乎都是空格，所以每次取 8 字节只和空格比较，异或后第一个非零字节就是第一个非空格；
+  // 它若是 '\t'、'\n'、'\r' 就越过它继续。缩进段通常不到 16 字节，实测比 SSE2/AVX2 的
+  // 16/32 字节版本更快，后者准备常量和 movemask 的固定开销在短段上占了大头
+  inline const char* skipWhitespace(const char* p, const char* end) {
+    while (p + 8 <= end) {
+      auto notSpace = swarLoad(p) ^ swarBroadcast(' ');
+      if (notSpace == 0) {
+        p += 8;
+        continue;
+      }
+      p += swarFirstByte(notSpace);
+      if (*p != '\t' && *p != '\n' && *p != '\r') return p;
+      ++p;
+    }
+    for (; p < end; ++p) {
+      if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') return p;
+    }
+    return end;
+  }
+
+  // 不是十进制数字的字节：小于 '0' 或者大于 '9'
+  // 先去掉最高位再加，字节之间不会进位，最高位本来就是 1 的字节也算大于 '9'
+  inline uint64_t swarNonDigit(uint64_t x) {
+    auto greater = ((x & swarBroadcast(0x7F)) + swarBroadcast(0x7F - '9')) | x;
+    return swarLessThan(x, '0') | (greater & swarBroadcast(0x80));
+  }
+
+  // 8 个字节是否都是数字：高半字节必须是 3，加 6 之后高半字节仍然是 3
+  inline bool swarAllDigits(uint64_t x) {
+    return ((x & swarBroadcast(0xF0)) | (((x + swarBroadcast(0x06)) & swarBroadcast(0xF0)) >> 4))
+           == swarBroadcast(0x33);
+  }
+
+  // 8 个数字字符的值，地址最低的字节是最高位，由调用方确保都是数字
+  // 每一步把相邻两组合并：1 位 × 8 → 2 位 × 4 → 4 位 × 2 → 8 位，只需要 3 次乘法
+  inline uint32_t swarParseEightDigits(uint64_t x) {
+    x -= swarBroadcast('0');
+    x = x * 10 + (x >> 8);
+    x = (((x & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+         + (((x >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))))
+        >> 32;
+    return static_cast<uint32_t>(x);
+  }
+
+  // 在 [p, end) 中找第一个不是数字的字节，没有则返回 end
+  // ID、时间戳和 17 位有效数字的小数都是成段的数字，每次检查 8 字节
+  inline const char* skipDigits(const char* p, const char* end) {
+    for (; p + 8 <= end; p += 8) {
+      auto hits = swarNonDigit(swarLoad(p));
+      if (hits) return p + swarFirstByte(hits);
+    }
+    while (p < end && '0' <= *p && *p <= '9') ++p;
+    return p;
+  }
+
+  // 一个 64 字节 block 的分类结果，第 k 位对应 block 中的第 k 个字节
+  struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;          // {}[]:,
+    uint64_t whitespace;
+  };
+
+  inline BlockMasks classifyScalar(const uint8_t* block) {
+    enum : uint8_t { QUOTE = 1, BACKSLASH = 2, OP = 4, WHITESPACE = 8 };
+    static constexpr auto classTable = []() {
+      std::array<uint8_t, 256> table{};
+      table['"'] = QUOTE;
+      table['\\'] = BACKSLASH;
+      for (char c : {'{', '}', '[', ']', ':', ','}) table[c] = OP;
+      for (char c : {' ', '\t', '\n', '\r'}) table[c] = WHITESPACE;
+      return table;
+    }();
+
+    BlockMasks masks{};
+    for (int k = 0; k < 64; ++k) {
+      uint64_t cls = classTable[block[k]];
+      masks.quote |= (cls & 1) << k;
+      masks.backslash |= ((cls >> 1) & 1) << k;
+      masks.op |= ((cls >> 2) & 1) << k;
+      masks.whitespace |= ((cls >> 3) & 1) << k;
+    }
+    return masks;
+  }
+
+  // 被转义的字节：奇数个连续反斜杠之后的那个字节
+  // prevEscaped 在 block 之间传递，上一个 block 以未配对的反斜杠结尾时为 1
+  inline uint64_t escapedBytes(uint64_t backslash, uint64_t& prevEscaped) {
+    constexpr uint64_t evenBits = 0x5555555555555555ULL;
+    backslash &= ~prevEscaped;
+    uint64_t followsEscape = (backslash << 1) | prevEscaped;
+    uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    prevEscaped = sequencesStartingOnEvenBits < oddSequenceStarts;
+    uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+  }
+
+  // 对 x 求前缀异或：结果的第 k 位是 x 的第 0..k 位的异或
+  // 以引号掩码为输入时，结果就是“处于字符串内”的掩码
+  inline uint64_t prefixXorScalar(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+  }
+
+#if JSON_SIMD_X86
+  // 与全 1 做无进位乘法等价于前缀异或
+  JSON_TARGET("pclmul,sse2") inline uint64_t prefixXorClmul(uint64_t x) {
+    __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<int64_t>(x)),
+                                           _mm_set1_epi8(-1),
+                                           0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+  }
+
+  // 用 pshufb 按低 4 位查表，查到的值与原字节相等即属于该字符集合
+  // 未使用的表项填 0x80：高位为 1 的输入字节查表得 0，其他字节都小于 0x80，都不会误匹配
+  JSON_TARGET("sse4.2") inline BlockMasks classifySse42(const uint8_t* block) {
+    const __m128i wsTable = _mm_setr_epi8(' ', -128, -128, -128, -128, -128, -128, -128,
+                                          -128, '\t', '\n', -128, -128, '\r', -128, -128);
+    const __m128i opTable = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                                          -128, -128, ':', '{', ',', '}', -128, -128);
+    const __m128i bracketTable = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                                               -128, -128, -128, '[', -128, ']', -128, -128);
+    BlockMasks masks{};
+    for (int k = 0; k < 64; k += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k));
+      __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+      __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+      __m128i op = _mm_or_si128(_mm_cmpeq_epi8(_mm_shuffle_epi8(opTable, v), v),
+                                _mm_cmpeq_epi8(_mm_shuffle_epi8(bracketTable, v), v));
+      __m128i ws = _mm_cmpeq_epi8(_mm_shuffle_epi8(wsTable, v), v);
+      masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(quote))) << k;
+      masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(backslash)))
+                         << k;
+      masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << k;
+      masks.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << k;
+    }
+    return masks;
+  }
+
+  JSON_TARGET("avx2") inline BlockMasks classifyAvx2(const uint8_t* block) {
+    const __m256i wsTable = _mm256_setr_epi8(
+      ' ', -128, -128, -128, -128, -128, -128, -128, -128, '\t', '\n', -128, -128, '\r', -128, -128,
+      ' ', -128, -128, -128, -128, -128, -128, -128, -128, '\t', '\n', -128, -128, '\r', -128, -128);
+    const __m256i opTable = _mm256_setr_epi8(
+      -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, ':', '{', ',', '}', -128, -128,
+      -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, ':', '{', ',', '}', -128, -128);
+    const __m256i bracketTable = _mm256_setr_epi8(
+      -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, '[', -128, ']', -128, -128,
+      -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, '[', -128, ']', -128, -128);
+    BlockMasks masks{};
+    for (int k = 0; k < 64; k += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + k));
+      __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+      __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+      __m256i op = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_shuffle_epi8(opTable, v), v),
+                                   _mm256_cmpeq_epi8(_mm256_shuffle_epi8(bracketTable, v), v));
+      __m256i ws = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(wsTable, v), v);
+      masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(quote))) << k;
+      masks.backslash |=
+        static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(backslash))) << k;
+      masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << k;
+      masks.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws)))
+                          << k;
+    }
+    return masks;
+  }
+
+  // 每次比较 16 字节，SSE2 是 x86-64 的基线，不需要运行时检测
+  inline const char* findStringSpecialSse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; p + 16 <= end; p += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+      int mask = _mm_movemask_epi8(hits);
+      if (mask) return p + trailingZeros(static_cast<uint64_t>(mask));
+    }
+    return findStringSpecialSwar(p, end);
+  }
+
+  JSON_TARGET("avx2") inline const char* findStringSpecialAvx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    for (; p + 32 <= end; p += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      __m256i hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+      auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+      if (mask) return p + trailingZeros(mask);
+    }
+    return findStringSpecialSse2(p, end);
+  }
+#endif
+
+  // 在 [p, end) 中找第一个 '"'、'\\' 或控制字符，没有则返回 end
+  inline const char* findStringSpecial(const char* p, const char* end) {
+#if JSON_SIMD_X86
+    if (bestKernel() == Kernel::AVX2) return findStringSpecialAvx2(p, end);
+    return findStringSpecialSse2(p, end);
+#else
+    return findStringSpecialSwar(p, end);
+#endif
+  }
+
+  // UTF-8 首字节之后需要的续字节个数和第一个续字节的取值范围（Unicode 表 3-7），
+  // 排除了过长编码、代理区和超出 U+10FFFF 的码点；不是合法首字节时 continuations 为 0
+  struct Utf8Lead {
+    uint8_t continuations;
+    uint8_t lower;
+    uint8_t upper;
+  };
+
+  constexpr Utf8Lead utf8Lead(uint8_t b) {
+    if (b < 0xC2) return {0, 0, 0};
+    if (b < 0xE0) return {1, 0x80, 0xBF};
+    if (b == 0xE0) return {2, 0xA0, 0xBF};
+    if (b == 0xED) return {2, 0x80, 0x9F};
+    if (b < 0xF0) return {2, 0x80, 0xBF};
+    if (b == 0xF0) return {3, 0x90, 0xBF};
+    if (b < 0xF4) return {3, 0x80, 0xBF};
+    if (b == 0xF4) return {3, 0x80, 0x8F};
+    return {0, 0, 0};
+  }
+
+  // 从 p 开始的一个完整且合法的多字节序列的长度；非法或者被 end 截断时返回 0
+  inline size_t utf8SequenceLength(const char* p, const char* end) {
+    auto lead = utf8Lead(static_cast<uint8_t>(*p));
+    if (lead.continuations == 0 || end - p <= lead.continuations) return 0;
+    auto c = static_cast<uint8_t>(p[1]);
+    if (c < lead.lower || c > lead.upper) return 0;
+    for (int k = 2; k <= lead.continuations; ++k) {
+      if ((static_cast<uint8_t>(p[k]) & 0xC0) != 0x80) return 0;
+    }
+    return lead.continuations + 1u;
+  }
+
+  // findStringSpecial 的校验版本：合法的多字节序列成段跳过，另外停在非法或被 end 截断的
+  // 多字节序列的首字节上。p 必须位于序列边界
+  inline const char* findStringSpecialUtf8Swar(const char* p, const char* end) {
+    while (p < end) {
+      for (; p + 8 <= end; p += 8) {
+        auto x = swarLoad(p);
+        auto hits = swarStringSpecial(x) | (x & swarBroadcast(0x80));
+        if (hits) {
+          p += swarFirstByte(hits);
+          break;
+        }
+      }
+      if (p + 8 > end) {
+        for (; p < end; ++p) {
+          auto c = static_cast<uint8_t>(*p);
+          if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) break;
+        }
+        if (p == end) break;
+      }
+      if (static_cast<uint8_t>(*p) < 0x80) return p;
+      auto n = utf8SequenceLength(p, end);
+      if (n == 0) return p;
+      p += n;
+    }
+    return end;
+  }
+
+  // 向量内核从 p 处接着用标量版本时，p 之前可能是一个没有结束（或者要靠后面的字节才能判定非法）
+  // 的序列，退回到 3 字节内最近的首字节，保证标量版本从序列边界开始；start 之前的字节不看
+  inline const char* utf8Boundary(const char* start, const char* p) {
+    // 用距离判断，不构造 start 之前的指针
+    for (int k = 1; k <= 3 && k <= p - start; ++k) {
+      auto b = static_cast<uint8_t>(p[-k]);
+      if (b >= 0xC0) return p - k;
+      if (b < 0x80) break;
+    }
+    return p;
+  }
+
+#if JSON_SIMD_X86
+  // 查表法校验 UTF-8（Keiser & Lemire）：每个字节与它前一个字节的高 4 位、低 4 位以及它自己的
+  // 高 4 位各查一次表，三个结果按位与之后非零即为错误；第三、四个字节是否应为续字节单独检查。
+  // 表项的每一位代表一类错误
+  namespace utf8 {
+    enum : uint8_t {
+      TOO_SHORT = 1 << 0,    // 首字节之后不是续字节
+      TOO_LONG = 1 << 1,     // ASCII 之后是续字节
+      OVERLONG_3 = 1 << 2,   // E0 80..9F
+      TOO_LARGE = 1 << 3,    // F4 90..BF 以及 F5..FF
+      SURROGATE = 1 << 4,    // ED A0..BF
+      OVERLONG_2 = 1 << 5,   // C0、C1
+      TOO_LARGE_1000 = 1 << 6,
+      OVERLONG_4 = 1 << 6,   // F0 80..8F
+      TWO_CONTS = 1 << 7,    // 两个连续的续字节，是否合法取决于更前面的字节
+      CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS,
+    };
+
+  #define JSON_UTF8_TABLES(set)                                                                    \
+    const auto byte1High = set(TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,        \
+                               TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,    \
+                               TOO_SHORT | OVERLONG_2, TOO_SHORT,                                  \
+                               TOO_SHORT | OVERLONG_3 | SURROGATE,                                 \
+                               TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);              \
+    const auto byte1Low = set(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2,   \
+                              CARRY, CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,                      \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000,                                  \
+                              CARRY | TOO_LARGE | TOO_LARGE_1000);                                 \
+    const auto byte2High = set(TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,  \
+                               TOO_SHORT, TOO_SHORT,                                               \
+                               TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000     \
+                                 | OVERLONG_4,                                                     \
+                               TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,         \
+                               TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,          \
+                               TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,          \
+                               TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT)
+
+    JSON_TARGET("sse4.2") inline __m128i table16(uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3,
+                                                 uint8_t t4, uint8_t t5, uint8_t t6, uint8_t t7,
+                                                 uint8_t t8, uint8_t t9, uint8_t t10, uint8_t t11,
+                                                 uint8_t t12, uint8_t t13, uint8_t t14,
+                                                 uint8_t t15) {
+      return _mm_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15);
+    }
+
+    JSON_TARGET("avx2") inline __m256i table32(uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3,
+                                               uint8_t t4, uint8_t t5, uint8_t t6, uint8_t t7,
+                                               uint8_t t8, uint8_t t9, uint8_t t10, uint8_t t11,
+                                               uint8_t t12, uint8_t t13, uint8_t t14,
+                                               uint8_t t15) {
+      return _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15));
+    }
+
+    // v 中每个出错字节的对应位为 1，prev 是紧挨在 v 之前的 16 字节
+    JSON_TARGET("sse4.2") inline uint32_t errorsSse42(__m128i v, __m128i prev) {
+      JSON_UTF8_TABLES(table16);
+      const __m128i low = _mm_set1_epi8(0x0F);
+      __m128i prev1 = _mm_alignr_epi8(v, prev, 15);
+      __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), low)),
+                      _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, low))),
+        _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+      // 只有 111_____ 之后第二个字节、1111____ 之后第三个字节的结果会 >= 0x80
+      __m128i third = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 14), _mm_set1_epi8(char(0xE0 - 0x80)));
+      __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 13), _mm_set1_epi8(char(0xF0 - 0x80)));
+      __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+      __m128i error = _mm_xor_si128(must23, special);
+      return ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())))
+             & 0xFFFF;
+    }
+
+    JSON_TARGET("avx2") inline uint32_t errorsAvx2(__m256i v, __m256i prev) {
+      JSON_UTF8_TABLES(table32);
+      const __m256i low = _mm256_set1_epi8(0x0F);
+      // v 的前一个 32 字节窗口：低 128 位来自 prev 的高半部分，高 128 位来自 v 的低半部分
+      __m256i shifted = _mm256_permute2x128_si256(prev, v, 0x21);
+      __m256i prev1 = _mm256_alignr_epi8(v, shifted, 15);
+      __m256i special = _mm256_and_si256(
+        _mm256_and_si256(
+          _mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low)),
+          _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, low))),
+        _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+      __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(v, shifted, 14),
+                                       _mm256_set1_epi8(char(0xE0 - 0x80)));
+      __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(v, shifted, 13),
+                                        _mm256_set1_epi8(char(0xF0 - 0x80)));
+      __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                        _mm256_set1_epi8(char(0x80)));
+      __m256i error = _mm256_xor_si256(must23, special);
+      return ~static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(error, _mm256_setzero_si256())));
+    }
+
+  #undef JSON_UTF8_TABLES
+  }
+
+  // 与 findStringSpecialSse2 在同一次读入中完成 UTF-8 校验：全是 ASCII 的 16 字节只多一次
+  // movemask；含多字节序列时查表，出错的那一组交给标量版本给出准确位置
+  JSON_TARGET("sse4.2") inline const char* findStringSpecialUtf8Sse42(const char* p,
+                                                                      const char* end) {
+    const char* start = p;
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i prev = _mm_setzero_si128();
+    bool prevAscii = true;
+    for (; p + 16 <= end; p += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+      auto special = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+      bool ascii = _mm_movemask_epi8(v) == 0;
+      if (!(ascii && prevAscii)) {
+        // 一个序列可能在特殊字节前被截断，所以特殊字节本身也参与检查
+        auto errors = utf8::errorsSse42(v, prev);
+        if (special) errors &= (special ^ (special - 1));
+        if (errors) return findStringSpecialUtf8Swar(utf8Boundary(start, p), end);
+      }
+      if (special) return p + trailingZeros(special);
+      prev = v;
+      prevAscii = ascii;
+    }
+    return findStringSpecialUtf8Swar(utf8Boundary(start, p), end);
+  }
+
+  JSON_TARGET("avx2") inline const char* findStringSpecialUtf8Avx2(const char* p, const char* end) {
+    const char* start = p;
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    __m256i prev = _mm256_setzero_si256();
+    bool prevAscii = true;
+    for (; p + 32 <= end; p += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      __m256i hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+      auto special = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+      bool ascii = _mm256_movemask_epi8(v) == 0;
+      if (!(ascii && prevAscii)) {
+        auto errors = utf8::errorsAvx2(v, prev);
+        if (special) errors &= (special ^ (special - 1));
+        if (errors) return findStringSpecialUtf8Swar(utf8Boundary(start, p), end);
+      }
+      if (special) return p + trailingZeros(special);
+      prev = v;
+      prevAscii = ascii;
+    }
+    return findStringSpecialUtf8Swar(utf8Boundary(start, p), end);
+  }
+#endif
+
+  // 在 [p, end) 中找第一个 '"'、'\\'、控制字符，或者非法、被 end 截断的 UTF-8 序列的首字节，
+  // 没有则返回 end；p 必须位于 UTF-8 序列的边界
+  inline const char* findStringSpecialUtf8(const char* p, const char* end) {
+#if JSON_SIMD_X86
+    switch (bestKernel()) {
+      case Kernel::AVX2:
+        return findStringSpecialUtf8Avx2(p, end);
+      case Kernel::SSE42:
+        return findStringSpecialUtf8Sse42(p, end);
+      default:
+        break;
+    }
+#endif
+    return findStringSpecialUtf8Swar(p, end);
+  }
+
+  // 跳过一个完整的值：只跟踪引号、转义和括号深度，不走状态机，不解码字符串，也不检查数值和关键字
+  // 输入不是合法的 JSON 时（例如字符串外出现反斜杠）各内核的结果可能不同，但都不会越过 end
+
+  // 逐字节的版本，也是非 x86 平台的实现
+  inline const char* skipContainerBytewise(const char* p, const char* end, size_t depth) {
+    bool inString = false;
+    for (; p < end; ++p) {
+      char c = *p;
+      if (inString) {
+        if (c == '\\') {
+          if (++p == end) break;
+        } else if (c == '"') {
+          inString = false;
+        }
+        continue;
+      }
+      switch (c) {
+        case '"':
+          inString = true;
+          break;
+        case '{':
+        case '[':
+          ++depth;
+          break;
+        case '}':
+        case ']':
+          if (--depth == 0) return p + 1;
+          break;
+      }
+    }
+    return nullptr;
+  }
+
+  // 一个 64 字节 block 中的引号、反斜杠和括号
+  struct BracketMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t open;   // { [
+    uint64_t close;  // } ]
+  };
+
+  // 跳过容器时跨 block 传递的状态
+  struct SkipCarry {
+    size_t depth;
+    uint64_t prevEscaped = 0;
+    uint64_t prevInString = 0;
+  };
+
+  // 字符串外的括号逐个更新深度，返回深度归零的括号在 block 中的位置，没有时返回 64
+  // 本 block 的右括号比当前深度少时深度不可能归零，直接按个数累加
+  inline int closeInBlock(const BracketMasks& masks, uint64_t inString, SkipCarry& carry) {
+    carry.prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+    uint64_t open = masks.open & ~inString;
+    uint64_t close = masks.close & ~inString;
+    size_t closes = popCount(close);
+    if (closes < carry.depth) {
+      carry.depth = carry.depth + popCount(open) - closes;
+      return 64;
+    }
+    for (uint64_t brackets = open | close; brackets != 0; brackets &= brackets - 1) {
+      int k = trailingZeros(brackets);
+      if (open >> k & 1) {
+        ++carry.depth;
+      } else if (--carry.depth == 0) {
+        return k;
+      }
+    }
+    return 64;
+  }
+
+#if JSON_SIMD_X86
+  // '[' 与 '{'、']' 与 '}' 只差 0x20 这一位，或上 0x20 之后各比较一次即可
+  JSON_TARGET("sse4.2") inline BracketMasks classifyBracketsSse42(const uint8_t* block) {
+    BracketMasks masks{};
+    for (int k = 0; k < 64; k += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k));
+      __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+      uint32_t quote = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+      uint32_t backslash = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+      uint32_t open = _mm_movemask_epi8(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')));
+      uint32_t close = _mm_movemask_epi8(_mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+      masks.quote |= static_cast<uint64_t>(quote) << k;
+      masks.backslash |= static_cast<uint64_t>(backslash) << k;
+      masks.open |= static_cast<uint64_t>(open) << k;
+      masks.close |= static_cast<uint64_t>(close) << k;
+    }
+    return masks;
+  }
+
+  JSON_TARGET("avx2") inline BracketMasks classifyBracketsAvx2(const uint8_t* block) {
+    BracketMasks masks{};
+    for (int k = 0; k < 64; k += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + k));
+      __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+      uint32_t quote = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+      uint32_t backslash = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+      uint32_t open = _mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')));
+      uint32_t close = _mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')));
+      masks.quote |= static_cast<uint64_t>(quote) << k;
+      masks.backslash |= static_cast<uint64_t>(backslash) << k;
+      masks.open |= static_cast<uint64_t>(open) << k;
+      masks.close |= static_cast<uint64_t>(close) << k;
+    }
+    return masks;
+  }
+
+  // 不满 64 字节的尾部用空白补齐，空白不影响引号和括号
+  JSON_TARGET("sse4.2,pclmul") inline const char* skipContainerSse42(const char* p,
+                                                                     const char* end,
+                                                                     size_t depth) {
+    SkipCarry carry{depth};
+    uint8_t tail[64];
+    // 按剩余的字节数推进，不构造 end 之后的指针
+    size_t size = end - p;
+    for (size_t done = 0; done < size; done += 64) {
+      const char* block = p + done;
+      auto data = reinterpret_cast<const uint8_t*>(block);
+      if (size - done < 64) {
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, block, size - done);
+        data = tail;
+      }
+      auto masks = classifyBracketsSse42(data);
+      uint64_t quote = masks.quote & ~escapedBytes(masks.backslash, carry.prevEscaped);
+      int k = closeInBlock(masks, prefixXorClmul(quote) ^ carry.prevInString, carry);
+      if (k < 64) return block + k + 1;
+    }
+    return nullptr;
+  }
+
+  JSON_TARGET("avx2,pclmul") inline const char* skipContainerAvx2(const char* p,
+                                                                  const char* end,
+                                                                  size_t depth) {
+    SkipCarry carry{depth};
+    uint8_t tail[64];
+    size_t size = end - p;
+    for (size_t done = 0; done < size; done += 64) {
+      const char* block = p + done;
+      auto data = reinterpret_cast<const uint8_t*>(block);
+      if (size - done < 64) {
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, block, size - done);
+        data = tail;
+      }
+      auto masks = classifyBracketsAvx2(data);
+      uint64_t quote = masks.quote & ~escapedBytes(masks.backslash, carry.prevEscaped);
+      int k = closeInBlock(masks, prefixXorClmul(quote) ^ carry.prevInString, carry);
+      if (k < 64) return block + k + 1;
+    }
+    return nullptr;
+  }
+#endif
+
+  // p 位于字符串外、深度为 depth 的容器之内，返回使深度归零的括号之后的位置；
+  // 容器在 end 之前没有闭合时返回 nullptr
+  inline const char* skipContainer(const char* p, const char* end, size_t depth = 1) {
+#if JSON_SIMD_X86
+    switch (bestKernel()) {
+      case Kernel::AVX2:
+        return skipContainerAvx2(p, end, depth);
+      case Kernel::SSE42:
+        return skipContainerSse42(p, end, depth);
+      default:
+        break;
+    }
+#endif
+    return skipContainerBytewise(p, end, depth);
+  }
+
+  // 给没有结构索引的调用方使用；JsonOnDemand 在索引上跳过，见 JsonOnDemand::skip
+  // p 指向一个值的首字节，返回这个值之后的位置，不检查值本身是否合法：
+  // 对象和数组跳到配对的括号之后，字符串跳到结束引号之后，数值和关键字跳到下一个分隔符或空白
+  // 对象、数组或字符串在 end 之前没有结束时返回 nullptr
+  inline const char* skipValue(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    switch (*p) {
+      case '{':
+      case '[':
+        return skipContainer(p + 1, end);
+      case '"':
+        // 结束引号前面的反斜杠必须是偶数个
+        for (++p; (p = static_cast<const char*>(std::memchr(p, '"', end - p))) != nullptr; ++p) {
+          const char* q = p;
+          while (q[-1] == '\\') --q;
+          if ((p - q) % 2 == 0) return p + 1;
+        }
+        return nullptr;
+      default:
+        while (p < end) {
+          switch (*p) {
+            case ',':
+            case '}':
+            case ']':
+            case ':':
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+              return p;
+            default:
+              ++p;
+          }
+        }
+        return p;
+    }
+  }
+}
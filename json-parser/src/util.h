@@ -2,7 +2,9 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 
 namespace util {
   inline bool isBlank(char c) {
@@ -17,58 +19,116 @@ namespace util {
     return ('0' <= c && c <= '9') || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F');
   }
 
+  // hex 字符的值，其余字节是 0xFF，与合法的值或在一起后高 4 位非零
+  inline constexpr auto hexTable = []() {
+    std::array<uint8_t, 256> table{};
+    for (int i = 0; i < 256; ++i) table[i] = 0xFF;
+    for (char c = '0'; c <= '9'; ++c) table[c] = c - '0';
+    for (char c = 'a'; c <= 'f'; ++c) table[c] = 10 + (c - 'a');
+    for (char c = 'A'; c <= 'F'; ++c) table[c] = 10 + (c - 'A');
+    return table;
+  }();
+
   // 由调用方确保输入是合法的 hex 字符
   inline uint8_t charToHex(char c) {
-    static constexpr auto hexTable = []() {
-      std::array<uint8_t, 256> table{};
-      for (int i = 0; i < 256; ++i) table[i] = 0;
-      for (char c = '0'; c <= '9'; ++c) table[c] = c - '0';
-      for (char c = 'a'; c <= 'f'; ++c) table[c] = 10 + (c - 'a');
-      for (char c = 'A'; c <= 'F'; ++c) table[c] = 10 + (c - 'A');
+    return hexTable[static_cast<unsigned char>(c)];
+  }
+
+  // 把 p 开始的 4 个 hex 字符转换成 16 位的值，有非 hex 字符时返回 false
+  // 4 次查表的结果按字节放进一个 32 位整数，一次检查是否都合法，再两步合并成 16 位，
+  // 不逐位移位累加；由调用方确保 p 之后至少有 4 个字节
+  inline bool parseHex4(const char* p, uint32_t& value) {
+    uint8_t bytes[4];
+    std::memcpy(bytes, p, sizeof(bytes));
+    uint32_t nibbles = static_cast<uint32_t>(hexTable[bytes[0]])
+                       | static_cast<uint32_t>(hexTable[bytes[1]]) << 8
+                       | static_cast<uint32_t>(hexTable[bytes[2]]) << 16
+                       | static_cast<uint32_t>(hexTable[bytes[3]]) << 24;
+    if (nibbles & 0xF0F0F0F0) return false;
+    // 相邻两个 nibble 合并成一个字节：低 16 位是前两位数字，高 16 位是后两位数字
+    uint32_t pairs = ((nibbles & 0x000F000F) << 4) | ((nibbles >> 8) & 0x000F000F);
+    value = (pairs & 0xFF) << 8 | (pairs >> 16);
+    return true;
+  }
+
+  // 词法分析用到的字符类别，状态机按类别而不是按字符分派
+  enum class CharClass : uint8_t {
+    OTHER,
+    WHITESPACE,
+    OBJECT_START,
+    OBJECT_END,
+    ARRAY_START,
+    ARRAY_END,
+    COLON,
+    COMMA,
+    QUOTE,
+    MINUS,
+    PLUS,
+    ZERO,
+    DIGIT,     // 1-9
+    POINT,
+    EXPONENT,  // e 或 E
+    LETTER_T,
+    LETTER_F,
+    LETTER_N,
+    COUNT,
+  };
+
+  inline CharClass charClass(char c) {
+    static constexpr auto classTable = []() {
+      std::array<CharClass, 256> table{};
+      for (int i = 0; i < 256; ++i) table[i] = CharClass::OTHER;
+      for (char c : {' ', '\t', '\n', '\r'}) table[c] = CharClass::WHITESPACE;
+      table['{'] = CharClass::OBJECT_START;
+      table['}'] = CharClass::OBJECT_END;
+      table['['] = CharClass::ARRAY_START;
+      table[']'] = CharClass::ARRAY_END;
+      table[':'] = CharClass::COLON;
+      table[','] = CharClass::COMMA;
+      table['"'] = CharClass::QUOTE;
+      table['-'] = CharClass::MINUS;
+      table['+'] = CharClass::PLUS;
+      table['0'] = CharClass::ZERO;
+      for (char c = '1'; c <= '9'; ++c) table[c] = CharClass::DIGIT;
+      table['.'] = CharClass::POINT;
+      table['e'] = CharClass::EXPONENT;
+      table['E'] = CharClass::EXPONENT;
+      table['t'] = CharClass::LETTER_T;
+      table['f'] = CharClass::LETTER_F;
+      table['n'] = CharClass::LETTER_N;
       return table;
     }();
 
-    return hexTable[static_cast<unsigned char>(c)];
+    return classTable[static_cast<unsigned char>(c)];
   }
 
   // 由调用方确保输入是合法的
-  inline uint32_t strToCodePoint(const std::string& input) {
-    return (charToHex(input[0]) << 12)
-      | (charToHex(input[1]) << 8)
-      | (charToHex(input[2]) << 4)
-      | charToHex(input[3])
-      ;
+  inline uint32_t strToCodePoint(std::string_view input) {
+    uint32_t codePoint = 0;
+    parseHex4(input.data(), codePoint);
+    return codePoint;
   }
 
-  // todo: 不使用异常如何处理非法参数？
-  inline std::string codePointToUtf8(uint32_t codePoint) {
-    if (codePoint > 0x10FFFF)
-      throw "invalid code point, exceeds U+10FFFF";
-
-    // [0xD800, 0xDFFF] 不代表合法值
-    // RFC 3629 明确规定这些码点不能被编码
-    if (0xD800 <= codePoint && codePoint <= 0xDFFF)
-      throw "invalid code point, in surrogate range";
-
-    std::string s;
-    s.reserve(4);
+  // 把码点编码成 1~4 个字节写到 out，返回写入的末尾
+  // 由调用方确保码点不超过 U+10FFFF 且不在代理区 [0xD800, 0xDFFF]（RFC 3629 规定这些码点不能被编码），
+  // 经过词法分析校验的转义序列解码后总是满足
+  inline char* encodeUtf8(uint32_t codePoint, char* out) {
     if (codePoint <= 0x7F) {
-      s += static_cast<uint8_t>(codePoint);
+      *out++ = static_cast<char>(codePoint);
     } else if (codePoint <= 0x7FF) {
-      s += static_cast<uint8_t>(0xC0 | (codePoint >> 6));
-      s += static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+      *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+      *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
     } else if (codePoint <= 0xFFFF) {
-      s += static_cast<uint8_t>(0xE0 | (codePoint >> 12));
-      s += static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
-      s += static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+      *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+      *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
     } else {
-      s += static_cast<uint8_t>(0xF0 | (codePoint >> 18));
-      s += static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
-      s += static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
-      s += static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+      *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+      *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
     }
-
-    return s;
+    return out;
   }
 
   inline bool isHighSurrogate(uint32_t codePoint) {
@@ -83,4 +143,78 @@ namespace util {
   inline uint32_t mergeSurrogate(uint32_t high, uint32_t low) {
     return ((high - 0xD800) << 10) + (low - 0xDC00) + 0x10000;
   }
+
+  // 解码从 escape 开始的一个转义序列，写到 dst 并把 dst 移到写入的末尾，返回转义序列之后的位置
+  // 由调用方确保输入已经通过词法分析的校验
+  inline const char* decodeEscape(const char* escape, char*& dst) {
+    const char* p = escape + 2;
+    switch (escape[1]) {
+      case 'b': *dst++ = '\b'; break;
+      case 'f': *dst++ = '\f'; break;
+      case 'n': *dst++ = '\n'; break;
+      case 'r': *dst++ = '\r'; break;
+      case 't': *dst++ = '\t'; break;
+      case 'u': {
+        uint32_t codePoint = 0, low = 0;
+        parseHex4(p, codePoint);
+        p += 4;
+        // 校验保证高位代理后紧跟 \uXXXX 形式的低位代理，一起解码成一个码点
+        if (isHighSurrogate(codePoint)) {
+          parseHex4(p + 2, low);
+          codePoint = mergeSurrogate(codePoint, low);
+          p += 6;
+        }
+        dst = encodeUtf8(codePoint, dst);
+        break;
+      }
+      default:
+        // '"'、'\\'、'/' 解码后就是字符本身
+        *dst++ = escape[1];
+    }
+    return p;
+  }
+
+  // 把字符串内容（不含两端引号）中的转义序列解码后追加到 out
+  // 解码只会变短，所以先按原长扩容再直接写进 out 的缓冲区，最后截到实际长度，中间不产生临时对象
+  // 由调用方确保输入已经通过词法分析的校验
+  inline void appendUnescaped(std::string_view raw, std::string& out) {
+    size_t base = out.size();
+    out.resize(base + raw.size());
+    char* dst = out.data() + base;
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    while (p < end) {
+      auto escape = static_cast<const char*>(std::memchr(p, '\\', end - p));
+      if (escape == nullptr) escape = end;
+      std::memcpy(dst, p, escape - p);
+      dst += escape - p;
+      if (escape == end) break;
+      p = decodeEscape(escape, dst);
+    }
+    out.resize(dst - out.data());
+  }
+
+  // 字符串内容（不含两端引号）解码后是否等于 text，逐个转义序列解码后比较，不分配内存
+  // 由调用方确保输入已经通过词法分析的校验
+  inline bool unescapedEquals(std::string_view raw, std::string_view text) {
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    const char* q = text.data();
+    const char* last = q + text.size();
+    while (p < end) {
+      auto escape = static_cast<const char*>(std::memchr(p, '\\', end - p));
+      if (escape == nullptr) escape = end;
+      auto run = static_cast<size_t>(escape - p);
+      if (static_cast<size_t>(last - q) < run || std::memcmp(p, q, run) != 0) return false;
+      q += run;
+      if (escape == end) break;
+      char decoded[4];
+      char* dst = decoded;
+      p = decodeEscape(escape, dst);
+      auto length = static_cast<size_t>(dst - decoded);
+      if (static_cast<size_t>(last - q) < length || std::memcmp(decoded, q, length) != 0) return false;
+      q += length;
+    }
+    return q == last;
+  }
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// 测试用的断言：失败时打印位置、表达式和附加说明，记下失败次数后继续，
+// main 最后返回 check::result()，有失败时为 1
+namespace check {
+  inline int& failures() {
+    static int count = 0;
+    return count;
+  }
+
+  inline void fail(const char* file, int line, const char* expression, const std::string& note) {
+    ++failures();
+    std::fprintf(stderr, "%s:%d: CHECK(%s) 失败 %s\n", file, line, expression, note.c_str());
+  }
+
+  inline int result() {
+    if (failures() != 0) std::fprintf(stderr, "%d 处检查失败\n", failures());
+    return failures() != 0;
+  }
+}
+
+// note 是失败时附加打印的说明，通常是输入本身
+#define CHECK(condition, note)                                           \
+  do {                                                                   \
+    if (!(condition)) check::fail(__FILE__, __LINE__, #condition, note); \
+  } while (0)
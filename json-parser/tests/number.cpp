@@ -0,0 +1,188 @@
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <spdlog/spdlog.h>
+#include "number.h"
+#include "check.h"
+
+// number::parse 与 strtod 逐位比较：Clinger 快速路径、Eisel-Lemire、超过 19 位有效数字时的回退，
+// 以及它们之间的边界；另外单独检查 8 位一组的 SWAR 数字累加、-0 和 locale
+// 测试程序本身运行在 "C" locale 下，strtod 在这里是参照
+
+namespace {
+  uint64_t bitsOf(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+  }
+
+  // text 的解析结果与 strtod（浮点数）或 strtoll/strtoull（64 位以内的整数）一致
+  void checkAgainstReference(const std::string& text) {
+    uint64_t payload = 0;
+    auto kind = number::parse(text, payload);
+    switch (kind) {
+      case NumberKind::INT64:
+        CHECK(static_cast<int64_t>(payload) == std::strtoll(text.c_str(), nullptr, 10), text);
+        break;
+      case NumberKind::UINT64:
+        CHECK(payload == std::strtoull(text.c_str(), nullptr, 10), text);
+        break;
+      case NumberKind::DOUBLE:
+      case NumberKind::BIG: {
+        auto expected = bitsOf(std::strtod(text.c_str(), nullptr));
+        CHECK(payload == expected, fmt::format("{}: {:#x} != {:#x}", text, payload, expected));
+        break;
+      }
+      default:
+        CHECK(false, fmt::format("{}: kind {}", text, static_cast<int>(kind)));
+    }
+  }
+
+  std::string digits(std::mt19937_64& random, size_t count) {
+    std::string out;
+    for (size_t k = 0; k < count; ++k) out += static_cast<char>('0' + random() % 10);
+    if (out[0] == '0') out[0] = static_cast<char>('1' + random() % 9);
+    return out;
+  }
+
+  void testFixedCases() {
+    const char* const CASES[] = {
+      // 快速路径的边界：w ≤ 2^53，|q| ≤ 22
+      "9007199254740992", "9007199254740993", "9007199254740992.0", "9007199254740993.0",
+      "1e22", "1e23", "9007199254740992e22", "9007199254740993e22", "1e-22", "1e-23",
+      "123456789e-22", "123456789e-23",
+      // 19 和 20 位有效数字：20 位开始走截断后的两端比较，可能回退
+      "1234567890123456789.5", "12345678901234567890.5", "9999999999999999999e-5",
+      "99999999999999999999e-5", "18446744073709551615", "18446744073709551616",
+      "-9223372036854775808", "-9223372036854775809", "9223372036854775808",
+      // 恰好在两个 double 中间，必须按偶数舍入，截断后两端不同，一定回退
+      "1.00000000000000011102230246251565404236316680908203125",
+      "1.00000000000000011102230246251565404236316680908203124",
+      "1.00000000000000011102230246251565404236316680908203126",
+      "9007199254740993.00000000000000000000000000000000000001",
+      "2.2250738585072011e-308", "2.2250738585072012e-308", "2.2250738585072014e-308",
+      "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+      "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308",
+      "179769313486231580793728971405301e276", "1e309", "1e-400",
+      "0.000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "000000000000000000000000000000000000000000000000000000000000000000000000000000012345678901"
+      "23456789012",
+      "100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000000000000.5",
+      "0", "0.0", "-0.0", "0e10", "1", "-1", "0.1", "0.2", "0.3", "3.141592653589793",
+    };
+    for (auto text : CASES) checkAgainstReference(text);
+  }
+
+  void testNegativeZero() {
+    for (auto text : {"-0", "-0.0", "-0e5", "-0E-5"}) {
+      uint64_t payload = 0;
+      auto kind = number::parse(text, payload);
+      CHECK(kind == NumberKind::DOUBLE, text);
+      auto d = number::toDouble(kind, payload);
+      CHECK(d == 0 && std::signbit(d), text);
+    }
+    uint64_t payload = 1;
+    CHECK(number::parse("0", payload) == NumberKind::INT64 && payload == 0, "0");
+  }
+
+  void testRandom() {
+    std::mt19937_64 random(20261017);
+    char buffer[64];
+    for (int k = 0; k < 400000; ++k) {
+      // 随机的 double 按最短和完整精度打印
+      double d;
+      uint64_t bits = random() & ~number::SIGN_BIT;
+      std::memcpy(&d, &bits, sizeof(d));
+      if (!std::isfinite(d)) continue;
+      std::snprintf(buffer, sizeof(buffer), "%.17g", d);
+      checkAgainstReference(buffer);
+      std::snprintf(buffer, sizeof(buffer), "%.*g", static_cast<int>(1 + random() % 16), d);
+      checkAgainstReference(buffer);
+      std::snprintf(buffer, sizeof(buffer), "-%.*e", static_cast<int>(random() % 20), d);
+      checkAgainstReference(buffer);
+    }
+    for (int k = 0; k < 300000; ++k) {
+      // 任意长度的有效数字和指数，覆盖截断、回退、上溢和下溢
+      auto count = 1 + random() % 40;
+      auto text = digits(random, count);
+      auto point = random() % (count + 1);
+      if (point != 0 && point != count) text.insert(point, ".");
+      if (random() % 2) text = fmt::format("{}e{}", text, static_cast<int>(random() % 700) - 360);
+      if (random() % 2) text = "-" + text;
+      checkAgainstReference(text);
+    }
+    for (int k = 0; k < 200000; ++k) {
+      // 1~20 位整数，包括超出 uint64 的
+      auto text = digits(random, 1 + random() % 20);
+      checkAgainstReference(text);
+      checkAgainstReference("-" + text);
+    }
+  }
+
+  // 8 位一组的累加必须与逐位累加相同，包括在非数字处停下和溢出回绕
+  void testSwarDigits() {
+    std::mt19937_64 random(8);
+    for (int k = 0; k < 200000; ++k) {
+      std::string text = digits(random, 1 + random() % 30);
+      if (random() % 3 == 0) text[random() % text.size()] = ".e-+/:"[random() % 6];
+      uint64_t w = 0;
+      auto p = number::accumulateDigits(text.data(), text.data() + text.size(), w);
+      uint64_t expected = 0;
+      const char* q = text.data();
+      for (; q < p; ++q) expected = expected * 10 + static_cast<uint64_t>(*q - '0');
+      CHECK(w == expected, text);
+      // 停下的位置之后不足 8 位，或者下 8 个字节里有非数字
+      size_t rest = text.size() - (p - text.data());
+      bool allDigits = rest >= 8;
+      for (size_t j = 0; allDigits && j < 8; ++j) allDigits = util::isDigit(p[j]);
+      CHECK(!allDigits, text);
+    }
+    for (uint32_t value : {0u, 1u, 9u, 10u, 12345678u, 87654321u, 99999999u, 10000000u}) {
+      auto text = fmt::format("{:08}", value);
+      CHECK(simd::swarAllDigits(simd::swarLoad(text.data())), text);
+      CHECK(simd::swarParseEightDigits(simd::swarLoad(text.data())) == value, text);
+    }
+    for (const char* text : {"1234567/", "1234567:", "/2345678", ":2345678", "1234 678"}) {
+      CHECK(!simd::swarAllDigits(simd::swarLoad(text)), text);
+    }
+  }
+
+  // 回退路径不能受 locale 影响；系统里没有小数点是 ',' 的 locale 时跳过
+  void testLocale() {
+    const char* const LOCALES[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "ru_RU.UTF-8", "de_DE"};
+    const char* chosen = nullptr;
+    for (auto name : LOCALES) {
+      if (std::setlocale(LC_NUMERIC, name) != nullptr) {
+        chosen = name;
+        break;
+      }
+    }
+    if (chosen == nullptr) {
+      spdlog::info("没有小数点是 ',' 的 locale，跳过 locale 检查");
+      return;
+    }
+    // 截断后两端不同，一定走回退路径
+    const char* text = "1.00000000000000011102230246251565404236316680908203125";
+    uint64_t payload = 0;
+    number::parse(text, payload);
+    std::setlocale(LC_NUMERIC, "C");
+    CHECK(payload == bitsOf(std::strtod(text, nullptr)), fmt::format("{} under {}", text, chosen));
+  }
+}
+
+int main() {
+  testFixedCases();
+  testNegativeZero();
+  testRandom();
+  testSwarDigits();
+  testLocale();
+  return check::result();
+}
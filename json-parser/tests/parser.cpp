@@ -0,0 +1,87 @@
+#include <string>
+#include <string_view>
+#include <spdlog/spdlog.h>
+#include "JsonDocument.h"
+#include "JsonParser.h"
+#include "check.h"
+
+// 游标按批分析，同一批里词法错误之前的文法错误和处理器的中止必须按原样报告
+
+namespace {
+  // 遇到内容是 "stop" 的字符串时中止
+  struct Stopper {
+    const char* abortReason = nullptr;
+
+    bool onObjectStart() { return true; }
+    bool onObjectEnd(size_t) { return true; }
+    bool onArrayStart() { return true; }
+    bool onArrayEnd(size_t) { return true; }
+    bool onKey(std::string_view) { return true; }
+    bool onNumber(const TapeToken&, std::string_view) { return true; }
+    bool onBool(bool) { return true; }
+    bool onNull() { return true; }
+
+    bool onString(std::string_view text) {
+      if (text != "stop") return true;
+      abortReason = "遇到 stop";
+      return false;
+    }
+  };
+
+  using ErrorCode = JsonParser::ErrorCode;
+
+  std::string describe(const JsonParser::Error& error) {
+    return fmt::format("code={} offset={}", static_cast<int>(error.code), error.offset);
+  }
+
+  // 像 JsonDocument 那样在中止时填上处理器记下的原因
+  JsonParser::Error withReason(JsonParser::Error error, const Stopper& stopper) {
+    if (error.code == JsonParser::ErrorCode::ABORTED) error.reason = stopper.abortReason;
+    return error;
+  }
+
+  // 用游标和结构索引两条路径解析，结果必须相同
+  template <typename Check>
+  void parseBoth(const std::string& input, Check&& check) {
+    JsonParser parser;
+    Stopper plain;
+    check(withReason(parser.parse(input, plain), plain), input + " cursor");
+    StructuralIndex index;
+    index.build(input);
+    Stopper indexed;
+    check(withReason(parser.parse(input, index, indexed), indexed), input + " index");
+  }
+
+  void expect(const std::string& input, ErrorCode code, size_t offset) {
+    parseBoth(input, [&](const JsonParser::Error& error, const std::string& note) {
+      CHECK(error.code == code && error.offset == offset, note + " " + describe(error));
+    });
+  }
+
+  void testPrecedence() {
+    // 文法错误在前，词法错误在同一批的后面
+    expect(R"([1 2, "\x"])", ErrorCode::UNEXPECTED_TOKEN, 3);
+    expect(R"({"a" 1, "\x"})", ErrorCode::UNEXPECTED_TOKEN, 5);
+    expect(R"(1 2 "\x")", ErrorCode::EXTRA_TOKEN, 2);
+    // 词法错误在前，或者 run 因为 token 用完而停下
+    expect(R"(["\x", 1 2])", ErrorCode::LEXER, 3);
+    expect(R"([1, "\x")", ErrorCode::LEXER, 6);
+    expect(R"(1 @)", ErrorCode::LEXER, 2);
+    expect(R"(1 "\x")", ErrorCode::LEXER, 4);
+    expect(R"([1, 2)", ErrorCode::UNEXPECTED_END, 5);
+
+    // 处理器的中止和它的原因不能被之后的词法错误覆盖
+    parseBoth(R"(["stop", "\x"])", [&](const JsonParser::Error& error, const std::string& note) {
+      CHECK(error.code == ErrorCode::ABORTED && error.offset == 1, note + " " + describe(error));
+      CHECK(std::string_view(error.what()) == "遇到 stop", note + " " + error.what());
+    });
+    JsonDocument document;
+    auto error = document.parse(R"([1 2, "\x"])");
+    CHECK(error.code == ErrorCode::UNEXPECTED_TOKEN && error.offset == 3, "JsonDocument " + describe(error));
+  }
+}
+
+int main() {
+  testPrecedence();
+  return check::result();
+}
@@ -0,0 +1,180 @@
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "JsonLexer.h"
+#include "check.h"
+
+// 推送模式和游标必须与一次性分析得到完全相同的 token 和错误：
+// 在每个字节边界切开输入分两次 feed，再逐字节 feed，与 lexTape 和 lex() 的结果逐个比较
+
+namespace {
+  // 覆盖转义、代理对、多字节字符、各种数值和关键字，以及在这些位置上出错的输入
+  const char* const INPUTS[] = {
+    R"({"a":[1,-2,3.5,-0.25e-3,1E+2,0,-0],"b":true,"c":false,"d":null})",
+    R"(["\"\\\/\b\f\n\r\t","é中","😀","x𝄞y"])",
+    R"(["é中😀", "a\u0000b"  ,  "   "])",
+    R"([12345678901234567890,-9223372036854775808,9223372036854775807,18446744073709551616])",
+    R"([1.7976931348623157e308,4.9e-324,1e400,123456789012345678901234.5,0.1e-99999])",
+    R"([3.14159265358979323846264338327950288, 2.5e-5 , 1e0])",
+    " \t\n\r[ true , false , null ] \n",
+    "[truefalse]",
+    "42",
+    "\"tail\"",
+    "",
+    "   ",
+    // 出错的输入
+    R"(["\x"])",
+    R"(["\u12G4"])",
+    R"(["\ud83d"])",
+    R"(["\ud83dx"])",
+    R"(["\ud83dA"])",
+    "[\"a\x01\"]",
+    "[\"\xC0\xAF\"]",
+    "[\"\xED\xA0\x80\"]",
+    "[\"\xF4\x90\x80\x80\"]",
+    "[\"\xE4\xB8\"]",
+    R"(["open)",
+    "[01]",
+    "[1.]",
+    "[-]",
+    "[1e]",
+    "[1e+]",
+    "[tru]",
+    "[nul",
+    "[fals",
+    "[@]",
+    "1 2 x",
+  };
+
+  struct Options {
+    const char* name;
+    JsonLexer::Options options;
+  };
+
+  const Options OPTIONS[] = {
+    {"default", {}},
+    {"parseNumbers", {true}},
+    {"exactDecimals", {false, true}},
+  };
+
+  bool same(const TapeToken& a, const TapeToken& b) {
+    return a.type == b.type && a.flags == b.flags && a.exponent == b.exponent
+           && a.length == b.length && a.offset == b.offset && a.payload == b.payload;
+  }
+
+  std::string describe(const TapeToken& token) {
+    return fmt::format("type={} flags={} exponent={} length={} offset={} payload={}",
+                       static_cast<int>(token.type),
+                       token.flags,
+                       token.exponent,
+                       token.length,
+                       token.offset,
+                       token.payload);
+  }
+
+  // 一次推送模式的结果：token、它们的原始文本按 lex() 的方式转换成的 Token，以及错误
+  struct Stream {
+    std::vector<TapeToken> tokens;
+    std::vector<std::string> displays;
+    JsonLexer::Error error;
+  };
+
+  template <typename Chunks>
+  Stream stream(const JsonLexer::Options& options, Chunks&& chunks) {
+    Stream result;
+    JsonLexer lexer(options);
+    auto onToken = [&](const TapeToken& token, std::string_view text) {
+      result.tokens.push_back(token);
+      // text 就是这个 token 的全部字节，把它当作输入、偏移置 0 转换
+      TapeToken local = token;
+      local.offset = 0;
+      result.displays.push_back(TokenTape::toToken(local, text)->display());
+    };
+    chunks([&](std::string_view chunk) { lexer.feed(chunk, onToken); });
+    result.error = lexer.finish(onToken);
+    return result;
+  }
+
+  void compare(const Stream& got,
+               const TokenTape& expected,
+               const std::vector<std::string>& displays,
+               const JsonLexer::Error& error,
+               const std::string& note) {
+    CHECK(got.error.code == error.code, note);
+    CHECK(!got.error || got.error.offset == error.offset,
+          fmt::format("{} offset {} != {}", note, got.error.offset, error.offset));
+    CHECK(got.error || got.error.offset == 0, note);
+    CHECK(got.tokens.size() == expected.size(),
+          fmt::format("{} {} tokens != {}", note, got.tokens.size(), expected.size()));
+    for (size_t k = 0; k < got.tokens.size() && k < expected.size(); ++k) {
+      CHECK(same(got.tokens[k], expected.tokens[k]),
+            fmt::format("{} token {}: {} != {}", note, k, describe(got.tokens[k]),
+                        describe(expected.tokens[k])));
+      CHECK(got.displays[k] == displays[k],
+            fmt::format("{} token {}: {} != {}", note, k, got.displays[k], displays[k]));
+    }
+  }
+
+  // stride 是切分位置的间隔，短输入在每个位置都切
+  void testInput(const Options& options, const std::string& input, size_t stride = 1) {
+    JsonLexer lexer(options.options);
+    TokenTape expected;
+    auto error = lexer.lexTape(input, expected);
+
+    JsonLexer::Error lexError;
+    std::vector<std::string> displays;
+    for (const auto& token : lexer.lex(input, lexError)) displays.push_back(token->display());
+    CHECK(lexError.code == error.code && lexError.offset == error.offset, input);
+
+    std::string note = fmt::format("[{}] {:?}", options.name, input);
+    // 整段一次 feed
+    compare(stream(options.options, [&](auto feed) { feed(input); }),
+            expected, displays, error, note + " whole");
+    // 在每个位置切成两段
+    for (size_t cut = 0; cut <= input.size(); cut += stride) {
+      auto got = stream(options.options, [&](auto feed) {
+        feed(std::string_view(input).substr(0, cut));
+        feed(std::string_view(input).substr(cut));
+      });
+      compare(got, expected, displays, error, fmt::format("{} cut {}", note, cut));
+    }
+    // 逐字节
+    compare(stream(options.options,
+                   [&](auto feed) {
+                     for (size_t k = 0; k < input.size(); ++k) feed(std::string_view(input).substr(k, 1));
+                   }),
+            expected, displays, error, note + " bytewise");
+
+    // 游标按批产生的 token 也必须相同
+    auto cursor = lexer.cursor(input);
+    std::vector<TapeToken> batched;
+    for (const auto& token : cursor) batched.push_back(token);
+    CHECK(cursor.error().code == error.code && cursor.error().offset == error.offset, note + " cursor");
+    CHECK(batched.size() == expected.size(), note + " cursor");
+    for (size_t k = 0; k < batched.size() && k < expected.size(); ++k) {
+      CHECK(same(batched[k], expected.tokens[k]), fmt::format("{} cursor token {}", note, k));
+    }
+  }
+
+  // 超过游标一批的长度，让批的边界落在各种 token 中间
+  std::string longInput() {
+    std::string input = "[";
+    for (int k = 0; k < 300; ++k) {
+      if (k != 0) input += ',';
+      input += fmt::format(R"({{"k{}":"v\n{}","n":{}.{}e{},"u":"é😀"}})",
+                           k, k, k * 7919, k, k % 5);
+    }
+    input += ']';
+    return input;
+  }
+}
+
+int main() {
+  for (const auto& options : OPTIONS) {
+    for (auto input : INPUTS) testInput(options, input);
+    testInput(options, longInput(), 61);
+  }
+  return check::result();
+}
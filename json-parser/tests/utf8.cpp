@@ -0,0 +1,148 @@
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "simd.h"
+#include "check.h"
+
+// findStringSpecialUtf8 的各个内核必须与一个按码点解码的标量参照给出相同的位置：
+// 过长编码、代理区、超出 U+10FFFF、孤立的续字节、跨 16/32 字节块边界的序列和被输入结尾截断的序列
+
+namespace {
+  // 参照实现：逐个解码码点再检查范围，不使用 simd.h 里的任何表
+  const char* reference(const char* p, const char* end) {
+    while (p < end) {
+      auto b = static_cast<uint8_t>(*p);
+      if (b < 0x80) {
+        if (b == '"' || b == '\\' || b < 0x20) return p;
+        ++p;
+        continue;
+      }
+      int length;
+      uint32_t codePoint;
+      if ((b & 0xE0) == 0xC0) {
+        length = 2;
+        codePoint = b & 0x1F;
+      } else if ((b & 0xF0) == 0xE0) {
+        length = 3;
+        codePoint = b & 0x0F;
+      } else if ((b & 0xF8) == 0xF0) {
+        length = 4;
+        codePoint = b & 0x07;
+      } else {
+        return p;
+      }
+      if (end - p < length) return p;
+      for (int k = 1; k < length; ++k) {
+        auto c = static_cast<uint8_t>(p[k]);
+        if ((c & 0xC0) != 0x80) return p;
+        codePoint = codePoint << 6 | (c & 0x3F);
+      }
+      static const uint32_t SMALLEST[] = {0, 0, 0x80, 0x800, 0x10000};
+      if (codePoint < SMALLEST[length]) return p;
+      if (codePoint >= 0xD800 && codePoint <= 0xDFFF) return p;
+      if (codePoint > 0x10FFFF) return p;
+      p += length;
+    }
+    return end;
+  }
+
+  struct Kernel {
+    const char* name;
+    const char* (*find)(const char*, const char*);
+  };
+
+  std::vector<Kernel> kernels() {
+    std::vector<Kernel> result = {
+      {"swar", simd::findStringSpecialUtf8Swar},
+      {"dispatch", simd::findStringSpecialUtf8},
+    };
+#if JSON_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) result.push_back({"sse4.2", simd::findStringSpecialUtf8Sse42});
+    if (__builtin_cpu_supports("avx2")) result.push_back({"avx2", simd::findStringSpecialUtf8Avx2});
+#endif
+    return result;
+  }
+
+  const std::vector<Kernel> KERNELS = kernels();
+
+  std::string hex(const std::string& input) {
+    std::string out;
+    for (unsigned char c : input) out += fmt::format("{:02X} ", c);
+    return out;
+  }
+
+  // 内核可能读到 end 之前的最后一个字节，把输入拷进恰好大小的缓冲区，让越界读能被 sanitizer 发现
+  void checkInput(const std::string& input) {
+    std::vector<char> buffer(input.begin(), input.end());
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+    auto expected = reference(begin, end) - begin;
+    for (const auto& kernel : KERNELS) {
+      auto got = kernel.find(begin, end) - begin;
+      CHECK(got == expected, fmt::format("{}: {} != {} in {}", kernel.name, got, expected, hex(input)));
+    }
+  }
+
+  // 所有的首字节与第二个字节的组合，后面补上合法的续字节，放在跨越块边界的各个位置上；
+  // 过长编码、代理区和超出范围的判断都只取决于这两个字节
+  void testPairs() {
+    for (int lead = 0x80; lead < 0x100; ++lead) {
+      for (int second = 0; second < 0x100; ++second) {
+        std::string sequence = {static_cast<char>(lead), static_cast<char>(second), '\x80', '\x80'};
+        for (size_t offset : {0, 13, 14, 15, 16, 29, 30, 31, 32, 33}) {
+          std::string input(offset, 'a');
+          input += sequence;
+          input.append(40, 'b');
+          checkInput(input);
+          // 在序列中间被输入结尾截断
+          for (size_t keep = 1; keep < sequence.size(); ++keep) {
+            checkInput(std::string(offset, 'a') + sequence.substr(0, keep));
+          }
+        }
+      }
+    }
+  }
+
+  void testRandom() {
+    const std::string PIECES[] = {
+      "a", "hello world", "0123456789abcdef", "\"", "\\", "\x01", "\x1F", "\x7F",
+      "\xC2\x80", "\xDF\xBF", "é", "中", "\xE0\xA0\x80", "\xEF\xBF\xBF", "\xED\x9F\xBF",
+      "\xEE\x80\x80", "😀", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF",
+      // 非法
+      "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xE0\x9F\xBF", "\xF0\x80\x80\xAF", "\xF0\x8F\xBF\xBF",
+      "\xED\xA0\x80", "\xED\xBF\xBF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", "\xFE",
+      "\x80", "\xBF", "\xC2", "\xE4\xB8", "\xF0\x9F\x98", "\xC2\x41", "\xE4\x41\x80",
+    };
+    constexpr size_t VALID = 19;
+    std::mt19937_64 random(17);
+    for (int k = 0; k < 200000; ++k) {
+      std::string input;
+      size_t pieces = 1 + random() % 40;
+      // 大多数输入只用合法片段，保证内核要跑过多个块才遇到结果
+      bool valid = random() % 4 != 0;
+      for (size_t j = 0; j < pieces; ++j) {
+        size_t limit = valid ? VALID : std::size(PIECES);
+        const auto& piece = PIECES[random() % limit];
+        // 特殊字节很快结束扫描，合法输入里少放
+        if (valid && piece.size() == 1 && static_cast<uint8_t>(piece[0]) < 0x20) continue;
+        if (valid && (piece == "\"" || piece == "\\") && random() % 8 != 0) continue;
+        input += piece;
+      }
+      checkInput(input);
+      // 截掉结尾的若干字节，可能截在序列中间
+      if (!input.empty()) checkInput(input.substr(0, input.size() - 1 - random() % std::min<size_t>(input.size(), 3)));
+    }
+  }
+}
+
+int main() {
+  std::string names;
+  for (const auto& kernel : KERNELS) names += std::string(" ") + kernel.name;
+  spdlog::info("UTF-8 内核：{}", names);
+  testPairs();
+  testRandom();
+  return check::result();
+}